@@ -0,0 +1,622 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * www.rt-labs.com
+ * Copyright 2021 rt-labs AB, Sweden.
+ *
+ * This software is licensed under the terms of the BSD 3-clause
+ * license. See the file LICENSE distributed with this software for
+ * full license information.
+ ********************************************************************/
+
+/*
+ * POSIX implementation of the OSAL, used to run the middleware as a
+ * Linux process. Build it instead of osal/osal.c, with osal/linux
+ * ahead of osal in the include path. test/Makefile builds it on the
+ * host and "make -C test check" runs a smoke test.
+ *
+ * Only the OSAL itself is portable so far. rte_fs.c uses FreeRTOS
+ * directly and the shell uses cyhal, so neither builds against this
+ * port yet.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/* add system specific types prior to including osal.h */
+#include "sys/osal_cc.h"
+#include "sys/osal_sys.h"
+
+#include "osal.h"
+
+#define USECS_PER_SEC  (1000 * 1000)
+#define NSECS_PER_SEC  (1000 * 1000 * 1000)
+#define NSECS_PER_USEC (1000)
+
+void * os_malloc (size_t size)
+{
+   return malloc (size);
+}
+
+void os_free (void * ptr)
+{
+   free (ptr);
+}
+
+/* Pools are not used on the host, all allocations go to the heap */
+void os_malloc_freeze (void)
+{
+}
+
+size_t os_malloc_stats (os_pool_stats_t * stats, size_t n)
+{
+   if (n > 0)
+   {
+      memset (&stats[0], 0, sizeof (stats[0]));
+   }
+   return 1;
+}
+
+/* Convert relative timeout in ms to absolute CLOCK_MONOTONIC time */
+static void os_abstime (uint32_t ms, struct timespec * ts)
+{
+   clock_gettime (CLOCK_MONOTONIC, ts);
+
+   ts->tv_sec += ms / 1000;
+   ts->tv_nsec += (ms % 1000) * 1000 * 1000;
+   if (ts->tv_nsec >= NSECS_PER_SEC)
+   {
+      ts->tv_sec += 1;
+      ts->tv_nsec -= NSECS_PER_SEC;
+   }
+}
+
+/* Condition variables wait on CLOCK_MONOTONIC so that timeouts are
+ * not affected by changes to the wall clock */
+static void os_cond_init (pthread_cond_t * cond)
+{
+   pthread_condattr_t attr;
+
+   pthread_condattr_init (&attr);
+   pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+   pthread_cond_init (cond, &attr);
+   pthread_condattr_destroy (&attr);
+}
+
+/* Wait on condition, returns non-zero on timeout */
+static int os_cond_wait (
+   pthread_cond_t * cond,
+   pthread_mutex_t * mutex,
+   const struct timespec * ts)
+{
+   if (ts == NULL)
+   {
+      return pthread_cond_wait (cond, mutex);
+   }
+   return pthread_cond_timedwait (cond, mutex, ts);
+}
+
+static int thread_priority (os_thread_priority_t priority)
+{
+   int min = sched_get_priority_min (SCHED_FIFO);
+   int max = sched_get_priority_max (SCHED_FIFO);
+
+   return min + ((max - min) * priority) / OS_PRIORITY_MAX;
+}
+
+typedef struct os_thread_entry
+{
+   void (*entry) (void * arg);
+   void * arg;
+} os_thread_entry_t;
+
+static void * os_thread_start (void * arg)
+{
+   os_thread_entry_t start = *(os_thread_entry_t *)arg;
+
+   free (arg);
+   start.entry (start.arg);
+   return NULL;
+}
+
+os_thread_t * os_thread_create (
+   const char * name,
+   os_thread_priority_t priority,
+   size_t stacksize,
+   void (*entry) (void * arg),
+   void * arg)
+{
+   os_thread_t * thread;
+   os_thread_entry_t * start;
+   pthread_attr_t attr;
+   struct sched_param param;
+   char thread_name[16];
+   int result;
+
+   CC_ASSERT (priority <= OS_PRIORITY_MAX);
+
+   thread = malloc (sizeof (*thread));
+   start = malloc (sizeof (*start));
+   CC_ASSERT (thread != NULL);
+   CC_ASSERT (start != NULL);
+
+   start->entry = entry;
+   start->arg = arg;
+
+   pthread_attr_init (&attr);
+   pthread_attr_setstacksize (&attr, MAX (stacksize, (size_t)PTHREAD_STACK_MIN));
+
+   /* Real-time scheduling requires CAP_SYS_NICE, fall back to the
+    * default policy if not permitted */
+   param.sched_priority = thread_priority (priority);
+   pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+   pthread_attr_setschedpolicy (&attr, SCHED_FIFO);
+   pthread_attr_setschedparam (&attr, &param);
+
+   result = pthread_create (thread, &attr, os_thread_start, start);
+   if (result == EPERM)
+   {
+      pthread_attr_setinheritsched (&attr, PTHREAD_INHERIT_SCHED);
+      result = pthread_create (thread, &attr, os_thread_start, start);
+   }
+   pthread_attr_destroy (&attr);
+
+   CC_UNUSED (result);
+   CC_ASSERT (result == 0);
+
+   /* Thread names are limited to 16 characters including termination */
+   snprintf (thread_name, sizeof (thread_name), "%s", name);
+   pthread_setname_np (*thread, thread_name);
+
+   return thread;
+}
+
+os_mutex_t * os_mutex_create (void)
+{
+   os_mutex_t * mutex;
+   pthread_mutexattr_t attr;
+
+   mutex = malloc (sizeof (*mutex));
+   CC_ASSERT (mutex != NULL);
+
+   pthread_mutexattr_init (&attr);
+   pthread_mutexattr_setprotocol (&attr, PTHREAD_PRIO_INHERIT);
+   pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+   pthread_mutex_init (mutex, &attr);
+   pthread_mutexattr_destroy (&attr);
+
+   return mutex;
+}
+
+void os_mutex_lock (os_mutex_t * mutex)
+{
+   pthread_mutex_lock (mutex);
+}
+
+void os_mutex_unlock (os_mutex_t * mutex)
+{
+   pthread_mutex_unlock (mutex);
+}
+
+void os_mutex_destroy (os_mutex_t * mutex)
+{
+   pthread_mutex_destroy (mutex);
+   free (mutex);
+}
+
+void os_usleep (uint32_t us)
+{
+   struct timespec ts;
+
+   ts.tv_sec = us / USECS_PER_SEC;
+   ts.tv_nsec = (us % USECS_PER_SEC) * NSECS_PER_USEC;
+   while (clock_nanosleep (CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR)
+      ;
+}
+
+uint32_t os_get_current_time_us (void)
+{
+   struct timespec ts;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (uint32_t)(ts.tv_sec * USECS_PER_SEC + ts.tv_nsec / NSECS_PER_USEC);
+}
+
+/* Ticks are nanoseconds of CLOCK_MONOTONIC */
+os_tick_t os_tick_current (void)
+{
+   struct timespec ts;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (os_tick_t)ts.tv_sec * NSECS_PER_SEC + ts.tv_nsec;
+}
+
+os_tick_t os_tick_from_us (uint32_t us)
+{
+   return (os_tick_t)us * NSECS_PER_USEC;
+}
+
+void os_tick_sleep (os_tick_t tick)
+{
+   struct timespec ts;
+
+   ts.tv_sec = tick / NSECS_PER_SEC;
+   ts.tv_nsec = tick % NSECS_PER_SEC;
+   while (clock_nanosleep (CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR)
+      ;
+}
+
+os_sem_t * os_sem_create (size_t count)
+{
+   os_sem_t * sem;
+
+   sem = malloc (sizeof (*sem));
+   CC_ASSERT (sem != NULL);
+
+   os_cond_init (&sem->cond);
+   pthread_mutex_init (&sem->mutex, NULL);
+   sem->count = count;
+
+   return sem;
+}
+
+bool os_sem_wait (os_sem_t * sem, uint32_t time)
+{
+   struct timespec ts;
+   int error = 0;
+
+   if (time != OS_WAIT_FOREVER)
+   {
+      os_abstime (time, &ts);
+   }
+
+   pthread_mutex_lock (&sem->mutex);
+   while (sem->count == 0)
+   {
+      error = os_cond_wait (
+         &sem->cond,
+         &sem->mutex,
+         (time != OS_WAIT_FOREVER) ? &ts : NULL);
+      if (error == ETIMEDOUT)
+      {
+         break;
+      }
+   }
+
+   if (sem->count > 0)
+   {
+      /* Did not timeout */
+      sem->count--;
+      pthread_mutex_unlock (&sem->mutex);
+      return false;
+   }
+
+   /* Timed out */
+   pthread_mutex_unlock (&sem->mutex);
+   return true;
+}
+
+void os_sem_signal (os_sem_t * sem)
+{
+   pthread_mutex_lock (&sem->mutex);
+   sem->count++;
+   pthread_cond_signal (&sem->cond);
+   pthread_mutex_unlock (&sem->mutex);
+}
+
+void os_sem_destroy (os_sem_t * sem)
+{
+   pthread_cond_destroy (&sem->cond);
+   pthread_mutex_destroy (&sem->mutex);
+   free (sem);
+}
+
+os_event_t * os_event_create (void)
+{
+   os_event_t * event;
+
+   event = malloc (sizeof (*event));
+   CC_ASSERT (event != NULL);
+
+   os_cond_init (&event->cond);
+   pthread_mutex_init (&event->mutex, NULL);
+   event->flags = 0;
+
+   return event;
+}
+
+bool os_event_wait (os_event_t * event, uint32_t mask, uint32_t * value, uint32_t time)
+{
+   struct timespec ts;
+   int error = 0;
+
+   if (time != OS_WAIT_FOREVER)
+   {
+      os_abstime (time, &ts);
+   }
+
+   pthread_mutex_lock (&event->mutex);
+   while ((event->flags & mask) == 0)
+   {
+      error = os_cond_wait (
+         &event->cond,
+         &event->mutex,
+         (time != OS_WAIT_FOREVER) ? &ts : NULL);
+      if (error == ETIMEDOUT)
+      {
+         break;
+      }
+   }
+
+   /* Same semantics as the FreeRTOS port: bits are not cleared */
+   *value = event->flags & mask;
+   pthread_mutex_unlock (&event->mutex);
+
+   return *value != 0;
+}
+
+void os_event_set (os_event_t * event, uint32_t value)
+{
+   pthread_mutex_lock (&event->mutex);
+   event->flags |= value;
+   pthread_cond_broadcast (&event->cond);
+   pthread_mutex_unlock (&event->mutex);
+}
+
+void os_event_clr (os_event_t * event, uint32_t value)
+{
+   pthread_mutex_lock (&event->mutex);
+   event->flags &= ~value;
+   pthread_mutex_unlock (&event->mutex);
+}
+
+void os_event_destroy (os_event_t * event)
+{
+   pthread_cond_destroy (&event->cond);
+   pthread_mutex_destroy (&event->mutex);
+   free (event);
+}
+
+os_mbox_t * os_mbox_create (size_t size)
+{
+   os_mbox_t * mbox;
+
+   mbox = malloc (sizeof (*mbox) + size * sizeof (void *));
+   CC_ASSERT (mbox != NULL);
+
+   os_cond_init (&mbox->cond);
+   pthread_mutex_init (&mbox->mutex, NULL);
+
+   mbox->r = 0;
+   mbox->w = 0;
+   mbox->count = 0;
+   mbox->size = size;
+
+   return mbox;
+}
+
+bool os_mbox_fetch (os_mbox_t * mbox, void ** msg, uint32_t time)
+{
+   struct timespec ts;
+   int error = 0;
+
+   if (time != OS_WAIT_FOREVER)
+   {
+      os_abstime (time, &ts);
+   }
+
+   pthread_mutex_lock (&mbox->mutex);
+   while (mbox->count == 0)
+   {
+      error = os_cond_wait (
+         &mbox->cond,
+         &mbox->mutex,
+         (time != OS_WAIT_FOREVER) ? &ts : NULL);
+      if (error == ETIMEDOUT)
+      {
+         pthread_mutex_unlock (&mbox->mutex);
+         return true;
+      }
+   }
+
+   *msg = mbox->msg[mbox->r++];
+   if (mbox->r == mbox->size)
+   {
+      mbox->r = 0;
+   }
+   mbox->count--;
+
+   pthread_cond_broadcast (&mbox->cond);
+   pthread_mutex_unlock (&mbox->mutex);
+   return false;
+}
+
+bool os_mbox_post (os_mbox_t * mbox, void * msg, uint32_t time)
+{
+   struct timespec ts;
+   int error = 0;
+
+   if (time != OS_WAIT_FOREVER)
+   {
+      os_abstime (time, &ts);
+   }
+
+   pthread_mutex_lock (&mbox->mutex);
+   while (mbox->count == mbox->size)
+   {
+      error = os_cond_wait (
+         &mbox->cond,
+         &mbox->mutex,
+         (time != OS_WAIT_FOREVER) ? &ts : NULL);
+      if (error == ETIMEDOUT)
+      {
+         pthread_mutex_unlock (&mbox->mutex);
+         return true;
+      }
+   }
+
+   mbox->msg[mbox->w++] = msg;
+   if (mbox->w == mbox->size)
+   {
+      mbox->w = 0;
+   }
+   mbox->count++;
+
+   pthread_cond_broadcast (&mbox->cond);
+   pthread_mutex_unlock (&mbox->mutex);
+   return false;
+}
+
+void os_mbox_destroy (os_mbox_t * mbox)
+{
+   pthread_cond_destroy (&mbox->cond);
+   pthread_mutex_destroy (&mbox->mutex);
+   free (mbox);
+}
+
+static void * os_timer_thread (void * arg)
+{
+   os_timer_t * timer = arg;
+   uint64_t expirations;
+
+   while (!timer->exit)
+   {
+      /* Blocks until the timer expires */
+      if (read (timer->fd, &expirations, sizeof (expirations)) != sizeof (expirations))
+      {
+         continue;
+      }
+
+      if (!timer->exit && timer->fn)
+         timer->fn (timer, timer->arg);
+   }
+
+   return NULL;
+}
+
+static void os_timer_arm (os_timer_t * timer, uint32_t us, bool oneshot)
+{
+   struct itimerspec its;
+
+   its.it_value.tv_sec = us / USECS_PER_SEC;
+   its.it_value.tv_nsec = (us % USECS_PER_SEC) * NSECS_PER_USEC;
+   if (oneshot)
+   {
+      its.it_interval.tv_sec = 0;
+      its.it_interval.tv_nsec = 0;
+   }
+   else
+   {
+      its.it_interval = its.it_value;
+   }
+
+   timerfd_settime (timer->fd, 0, &its, NULL);
+}
+
+os_timer_t * os_timer_create (
+   uint32_t us,
+   void (*fn) (os_timer_t *, void * arg),
+   void * arg,
+   bool oneshot)
+{
+   os_timer_t * timer;
+   pthread_attr_t attr;
+   struct sched_param param;
+   int result;
+
+   timer = malloc (sizeof (*timer));
+   CC_ASSERT (timer != NULL);
+
+   timer->exit = false;
+   timer->fn = fn;
+   timer->arg = arg;
+   timer->us = us;
+   timer->oneshot = oneshot;
+
+   timer->fd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC);
+   CC_ASSERT (timer->fd >= 0);
+
+   /* Timer callbacks run at the highest priority, like the FreeRTOS
+    * timer service task */
+   pthread_attr_init (&attr);
+   param.sched_priority = thread_priority (OS_PRIORITY_MAX);
+   pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+   pthread_attr_setschedpolicy (&attr, SCHED_FIFO);
+   pthread_attr_setschedparam (&attr, &param);
+
+   result = pthread_create (&timer->thread, &attr, os_timer_thread, timer);
+   if (result == EPERM)
+   {
+      pthread_attr_setinheritsched (&attr, PTHREAD_INHERIT_SCHED);
+      result = pthread_create (&timer->thread, &attr, os_timer_thread, timer);
+   }
+   pthread_attr_destroy (&attr);
+
+   CC_UNUSED (result);
+   CC_ASSERT (result == 0);
+   pthread_setname_np (timer->thread, "os_timer");
+
+   return timer;
+}
+
+void os_timer_set (os_timer_t * timer, uint32_t us)
+{
+   timer->us = us;
+}
+
+void os_timer_start (os_timer_t * timer)
+{
+   /* A zero period would disarm the timer */
+   os_timer_arm (timer, MAX (timer->us, 1u), timer->oneshot);
+}
+
+void os_timer_stop (os_timer_t * timer)
+{
+   struct itimerspec its;
+
+   memset (&its, 0, sizeof (its));
+   timerfd_settime (timer->fd, 0, &its, NULL);
+}
+
+void os_timer_destroy (os_timer_t * timer)
+{
+   /* Wake the timer thread so that it can observe the exit flag */
+   timer->exit = true;
+   os_timer_arm (timer, 1, true);
+   pthread_join (timer->thread, NULL);
+
+   close (timer->fd);
+   free (timer);
+}
+
+__attribute__ ((weak)) uint32_t os_rand (void)
+{
+   static unsigned int seed;
+
+   if (seed == 0)
+   {
+      seed = (unsigned int)os_tick_current();
+   }
+   return rand_r (&seed);
+}
+
+__attribute__ ((weak)) void os_system_reset (void)
+{
+   printf ("system reset not implemented\n");
+}
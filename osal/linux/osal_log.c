@@ -0,0 +1,66 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * www.rt-labs.com
+ * Copyright 2021 rt-labs AB, Sweden.
+ *
+ * This software is licensed under the terms of the BSD 3-clause
+ * license. See the file LICENSE distributed with this software for
+ * full license information.
+ ********************************************************************/
+
+#include "osal_log.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+void os_log_impl (uint8_t type, const char * fmt, ...)
+{
+   va_list list;
+   unsigned long ms = os_tick_current() / (1000 * 1000);
+
+   switch (LOG_LEVEL_GET (type))
+   {
+   case LOG_LEVEL_VERBOSE:
+      printf ("%10lu [VERBOSE] ", ms);
+      break;
+   case LOG_LEVEL_DEBUG:
+      printf ("%10lu [DEBUG] ", ms);
+      break;
+   case LOG_LEVEL_INFO:
+      printf ("%10lu [INFO ] ", ms);
+      break;
+   case LOG_LEVEL_WARNING:
+      printf ("%10lu [WARN ] ", ms);
+      break;
+   case LOG_LEVEL_ERROR:
+      printf ("%10lu [ERROR] ", ms);
+      break;
+   case LOG_LEVEL_FATAL:
+      printf ("%10lu [FATAL] ", ms);
+      break;
+   default:
+      break;
+   }
+
+   va_start (list, fmt);
+   vprintf (fmt, list);
+   va_end (list);
+   fflush (stdout);
+}
+
+os_log_t os_log = os_log_impl;
+
+/* Logging is not time critical on the host, keep formatting in the
+ * caller's context */
+void os_log_deferred_init (void)
+{
+}
+
+uint32_t os_log_deferred_dropped (void)
+{
+   return 0;
+}
@@ -21,6 +21,7 @@
 
 #include "FreeRTOSConfig.h"
 #include "FreeRTOS.h"
+#include "task.h"
 
 /* add system specific types prior to including osal.h */
 #include "sys/osal_cc.h"
@@ -31,16 +32,238 @@
 #define TMO_TO_TICKS(ms)                                                       \
    ((ms == OS_WAIT_FOREVER) ? portMAX_DELAY : (ms) / portTICK_PERIOD_MS)
 
+/* Timer periods are rounded up, a period shorter than one tick must not
+ * become zero */
+#define US_TO_TICKS_CEIL(us)                                                   \
+   ((TickType_t)(((uint64_t)(us) + (1000u * portTICK_PERIOD_MS) - 1) /         \
+                 (1000u * portTICK_PERIOD_MS)))
+
+/* When enabled, os_usleep() sleeps whole ticks and busy-waits for the
+ * remaining part using os_get_current_time_us(). This gives sleeps
+ * shorter than a tick, at the cost of spinning for up to one tick.
+ * Requires a microsecond os_get_current_time_us(), such as the one
+ * enabled by UTILS_HIRES_TIMER. */
+#ifndef OSAL_USLEEP_HYBRID
+#define OSAL_USLEEP_HYBRID 0
+#endif
+
+/* Fixed-block pools behind os_malloc(). Each pool serves requests up to
+ * its block size with O(1) alloc/free from a free list. Larger requests,
+ * and requests when all suitable pools are exhausted, go to the heap.
+ *
+ * Only enable this if every os_malloc() block is released with
+ * os_free(). Passing a pool block to free() corrupts the heap. The
+ * prebuilt uphy/libu-phy.a does not reference os_free at all and
+ * pnet_api.obj releases os_malloc() memory with free(), so with the
+ * shipped library this option is NOT safe. It is intended for builds
+ * where the stack library is rebuilt to use os_free(). */
+#ifndef OSAL_POOL_ENABLE
+#define OSAL_POOL_ENABLE 0
+#endif
+
+/* Refuse heap allocations after os_malloc_freeze() */
+#ifndef OSAL_POOL_NO_MALLOC_AFTER_INIT
+#define OSAL_POOL_NO_MALLOC_AFTER_INIT 0
+#endif
+
+/* Pool configuration as POOL (block size, number of blocks), sorted by
+ * increasing block size. Block sizes must be unique. */
+#ifndef OSAL_POOLS
+#define OSAL_POOLS(POOL)                                                       \
+   POOL (32, 64)                                                               \
+   POOL (128, 32)                                                              \
+   POOL (512, 16)                                                              \
+   POOL (1536, 8)
+#endif
+
+#if OSAL_POOL_ENABLE
+
+#define OS_POOL_BLOCK_SIZE(size) (((size) + 7u) & ~7u)
+
+#define OS_POOL_STORAGE(size, count)                                           \
+   static uint64_t os_pool_storage_##size[OS_POOL_BLOCK_SIZE (size) / 8 * (count)];
+
+#define OS_POOL_ENTRY(size, count)                                             \
+   {.start = (uint8_t *)os_pool_storage_##size,                                \
+    .end = (uint8_t *)os_pool_storage_##size + sizeof (os_pool_storage_##size), \
+    .stats = {.block_size = OS_POOL_BLOCK_SIZE (size), .blocks = count}},
+
+typedef struct os_pool_block
+{
+   struct os_pool_block * next;
+} os_pool_block_t;
+
+typedef struct os_pool
+{
+   uint8_t * start;
+   uint8_t * end;
+   uint32_t unused; /* Blocks never allocated, taken from the end */
+   os_pool_block_t * free;
+   os_pool_stats_t stats;
+} os_pool_t;
+
+OSAL_POOLS (OS_POOL_STORAGE)
+
+static os_pool_t os_pools[] = {OSAL_POOLS (OS_POOL_ENTRY)};
+
+#endif /* OSAL_POOL_ENABLE */
+
+/* Heap allocations made by the stack library are released with free(),
+ * so only failures are counted for the heap. Tracking used blocks here
+ * would only ever grow. */
+static os_pool_stats_t os_heap_stats;
+static bool os_malloc_frozen;
+
+#if OSAL_POOL_ENABLE
+static void os_stats_alloc (os_pool_stats_t * stats)
+{
+   stats->used++;
+   if (stats->used > stats->high_water)
+   {
+      stats->high_water = stats->used;
+   }
+}
+
+static void * os_pool_alloc (size_t size)
+{
+   os_pool_t * pool;
+   void * block = NULL;
+   size_t ix;
+
+   taskENTER_CRITICAL();
+   for (ix = 0; ix < NELEMENTS (os_pools) && block == NULL; ix++)
+   {
+      pool = &os_pools[ix];
+      if (size > pool->stats.block_size)
+      {
+         continue;
+      }
+
+      if (pool->free != NULL)
+      {
+         block = pool->free;
+         pool->free = pool->free->next;
+      }
+      else if (pool->unused < pool->stats.blocks)
+      {
+         block = pool->start + pool->unused * pool->stats.block_size;
+         pool->unused++;
+      }
+      else
+      {
+         /* Exhausted, try the next larger pool or the heap */
+         pool->stats.spills++;
+         continue;
+      }
+
+      os_stats_alloc (&pool->stats);
+   }
+   taskEXIT_CRITICAL();
+
+   return block;
+}
+
+static bool os_pool_free (void * ptr)
+{
+   os_pool_t * pool;
+   os_pool_block_t * block = ptr;
+   size_t ix;
+
+   for (ix = 0; ix < NELEMENTS (os_pools); ix++)
+   {
+      pool = &os_pools[ix];
+      if ((uint8_t *)ptr >= pool->start && (uint8_t *)ptr < pool->end)
+      {
+         taskENTER_CRITICAL();
+         block->next = pool->free;
+         pool->free = block;
+         pool->stats.used--;
+         taskEXIT_CRITICAL();
+         return true;
+      }
+   }
+
+   return false;
+}
+#endif /* OSAL_POOL_ENABLE */
+
 void * os_malloc (size_t size)
 {
-   return malloc (size);
+   void * ptr;
+
+#if OSAL_POOL_ENABLE
+   ptr = os_pool_alloc (size);
+   if (ptr != NULL)
+   {
+      return ptr;
+   }
+#endif
+
+   if (OSAL_POOL_NO_MALLOC_AFTER_INIT && os_malloc_frozen)
+   {
+      ptr = NULL;
+   }
+   else
+   {
+      ptr = malloc (size);
+   }
+
+   if (ptr == NULL)
+   {
+      taskENTER_CRITICAL();
+      os_heap_stats.failures++;
+      taskEXIT_CRITICAL();
+   }
+
+   return ptr;
 }
 
 void os_free (void * ptr)
 {
+   if (ptr == NULL)
+   {
+      return;
+   }
+
+#if OSAL_POOL_ENABLE
+   if (os_pool_free (ptr))
+   {
+      return;
+   }
+#endif
+
    free (ptr);
 }
 
+void os_malloc_freeze (void)
+{
+   os_malloc_frozen = true;
+}
+
+size_t os_malloc_stats (os_pool_stats_t * stats, size_t n)
+{
+   size_t count = 0;
+
+   taskENTER_CRITICAL();
+#if OSAL_POOL_ENABLE
+   for (count = 0; count < NELEMENTS (os_pools); count++)
+   {
+      if (count < n)
+      {
+         stats[count] = os_pools[count].stats;
+      }
+   }
+#endif
+   if (count < n)
+   {
+      stats[count] = os_heap_stats;
+   }
+   count++;
+   taskEXIT_CRITICAL();
+
+   return count;
+}
+
 static uint32_t thread_priority[] = {
    0,
    (configMAX_PRIORITIES * 1 / 7),
@@ -98,13 +321,26 @@ void os_mutex_destroy (os_mutex_t * mutex)
 
 void os_usleep (uint32_t us)
 {
+#if OSAL_USLEEP_HYBRID
+   uint32_t start = os_get_current_time_us();
+   TickType_t ticks = us / (1000u * portTICK_PERIOD_MS);
+
+   if (ticks > 0)
+   {
+      vTaskDelay (ticks);
+   }
+
+   while ((uint32_t)(os_get_current_time_us() - start) < us)
+      ;
+#else
    vTaskDelay ((us / portTICK_PERIOD_MS) / 1000);
+#endif
 }
 
 /* allow override with high precision timer */
 __attribute__ ((weak)) uint32_t os_get_current_time_us (void)
 {
-   return 1000 * (xTaskGetTickCount() / portTICK_PERIOD_MS);
+   return 1000 * (xTaskGetTickCount() * portTICK_PERIOD_MS);
 }
 
 os_tick_t os_tick_current (void)
@@ -230,7 +466,7 @@ os_timer_t * os_timer_create (
 {
    os_timer_t * timer;
 
-   timer = malloc (sizeof (*timer));
+   timer = os_malloc (sizeof (*timer));
    CC_ASSERT (timer != NULL);
 
    timer->fn  = fn;
@@ -239,7 +475,7 @@ os_timer_t * os_timer_create (
 
    timer->handle = xTimerCreate (
       "os_timer",
-      (us / portTICK_PERIOD_MS) / 1000,
+      US_TO_TICKS_CEIL (us),
       oneshot ? pdFALSE : pdTRUE,
       timer,
       os_timer_callback);
@@ -257,7 +493,7 @@ void os_timer_start (os_timer_t * timer)
    /* Start timer by updating the period */
    BaseType_t status = xTimerChangePeriod (
       timer->handle,
-      (timer->us / portTICK_PERIOD_MS) / 1000,
+      US_TO_TICKS_CEIL (timer->us),
       portMAX_DELAY);
 
    CC_UNUSED (status);
@@ -276,7 +512,7 @@ void os_timer_destroy (os_timer_t * timer)
    BaseType_t status = xTimerDelete (timer->handle, portMAX_DELAY);
    CC_UNUSED (status);
    CC_ASSERT (status == pdPASS);
-   free (timer);
+   os_free (timer);
 }
 
 __attribute__ ((weak)) uint32_t os_rand (void)
@@ -88,9 +88,37 @@ typedef void os_timer_t;
 
 typedef uint64_t os_tick_t;
 
+/** Allocation statistics for one os_malloc() pool */
+typedef struct os_pool_stats
+{
+   size_t block_size;   /**< Block size, 0 for heap allocations */
+   uint32_t blocks;     /**< Number of blocks, 0 for heap allocations */
+   uint32_t used;       /**< Currently allocated blocks, 0 for heap */
+   uint32_t high_water; /**< Max number of blocks allocated at once */
+   uint32_t spills;     /**< Requests passed on because pool was empty */
+   uint32_t failures;   /**< os_malloc() calls that returned NULL */
+} os_pool_stats_t;
+
 void * os_malloc (size_t size);
 void os_free (void * ptr);
 
+/**
+ * Mark the end of initialisation. When the port is built with
+ * OSAL_POOL_NO_MALLOC_AFTER_INIT, os_malloc() requests that can not be
+ * served from a pool fail instead of falling back to the heap.
+ */
+void os_malloc_freeze (void);
+
+/**
+ * Get os_malloc() statistics, one entry per pool followed by one entry
+ * for heap allocations.
+ *
+ * @param stats   Array to fill
+ * @param n       Number of entries in \a stats
+ * @return number of entries available, may be larger than \a n
+ */
+size_t os_malloc_stats (os_pool_stats_t * stats, size_t n);
+
 void os_usleep (uint32_t us);
 uint32_t os_get_current_time_us (void);
 
@@ -17,40 +17,572 @@
 #include "FreeRTOSConfig.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include <ctype.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
-void os_log_impl (uint8_t type, const char * fmt, ...)
+/* Size of deferred log buffer, must be a power of two */
+#ifndef OS_LOG_DEFERRED_BUFFER_SIZE
+#define OS_LOG_DEFERRED_BUFFER_SIZE 4096
+#endif
+
+/* Max number of argument bytes stored per deferred message */
+#ifndef OS_LOG_DEFERRED_ARGS_MAX
+#define OS_LOG_DEFERRED_ARGS_MAX 96
+#endif
+
+/* Max length of a string argument stored in a deferred message */
+#ifndef OS_LOG_DEFERRED_STR_MAX
+#define OS_LOG_DEFERRED_STR_MAX 32
+#endif
+
+#ifndef OS_LOG_DEFERRED_PERIOD_MS
+#define OS_LOG_DEFERRED_PERIOD_MS 10
+#endif
+
+#define OS_LOG_DEFERRED_STACK_SIZE 2048
+#define OS_LOG_DEFERRED_MASK       (OS_LOG_DEFERRED_BUFFER_SIZE - 1)
+#define OS_LOG_ALIGN(n)            (((n) + 3u) & ~3u)
+
+CC_STATIC_ASSERT ((OS_LOG_DEFERRED_BUFFER_SIZE & OS_LOG_DEFERRED_MASK) == 0);
+
+#define OS_LOG_PRECISION_NONE -1
+#define OS_LOG_PRECISION_STAR -2
+
+typedef enum os_log_arg
 {
-   va_list list;
+   OS_LOG_ARG_NONE,
+   OS_LOG_ARG_INT,
+   OS_LOG_ARG_LONG,
+   OS_LOG_ARG_LLONG,
+   OS_LOG_ARG_DOUBLE,
+   OS_LOG_ARG_PTR,
+   OS_LOG_ARG_STR,
+} os_log_arg_t;
+
+/* Deferred message, followed by args_size bytes of packed arguments.
+ * A record with fmt == NULL is padding up to the end of the buffer. */
+typedef struct os_log_record
+{
+   uint32_t tick;
+   const char * fmt;
+   uint16_t size;
+   uint16_t args_size;
+   uint8_t type;
+} os_log_record_t;
 
+static uint8_t log_buffer[OS_LOG_DEFERRED_BUFFER_SIZE] CC_ALIGNED (4);
+static volatile uint32_t log_head;
+static volatile uint32_t log_tail;
+static volatile uint32_t log_dropped;
+
+static void os_log_prefix (uint8_t type, uint32_t tick)
+{
    switch (LOG_LEVEL_GET (type))
    {
    case LOG_LEVEL_VERBOSE:
-      printf ("%10ld [VERBOSE] ", xTaskGetTickCount());
+      printf ("%10ld [VERBOSE] ", tick);
       break;
    case LOG_LEVEL_DEBUG:
-      printf ("%10ld [DEBUG] ", xTaskGetTickCount());
+      printf ("%10ld [DEBUG] ", tick);
       break;
    case LOG_LEVEL_INFO:
-      printf ("%10ld [INFO ] ", xTaskGetTickCount());
+      printf ("%10ld [INFO ] ", tick);
       break;
    case LOG_LEVEL_WARNING:
-      printf ("%10ld [WARN ] ", xTaskGetTickCount());
+      printf ("%10ld [WARN ] ", tick);
       break;
    case LOG_LEVEL_ERROR:
-      printf ("%10ld [ERROR] ", xTaskGetTickCount());
+      printf ("%10ld [ERROR] ", tick);
       break;
    case LOG_LEVEL_FATAL:
-      printf ("%10ld [FATAL] ", xTaskGetTickCount());
+      printf ("%10ld [FATAL] ", tick);
       break;
    default:
       break;
    }
+}
+
+void os_log_impl (uint8_t type, const char * fmt, ...)
+{
+   va_list list;
+
+   os_log_prefix (type, xTaskGetTickCount());
 
    va_start (list, fmt);
    vprintf (fmt, list);
    va_end (list);
 }
 
-os_log_t os_log = os_log_impl;
\ No newline at end of file
+os_log_t os_log = os_log_impl;
+
+/**
+ * Parse a printf conversion specification
+ *
+ * @param p          In:  Character following '%'
+ * @param arg        Out: Type of the converted argument
+ * @param stars      Out: Number of '*' width/precision arguments
+ * @param precision  Out: Precision, OS_LOG_PRECISION_NONE if not given
+ *                        or OS_LOG_PRECISION_STAR if given by the last
+ *                        '*' argument
+ * @return pointer to character following the specification
+ */
+static const char * os_log_parse_spec (
+   const char * p,
+   os_log_arg_t * arg,
+   int * stars,
+   int * precision)
+{
+   int length = 0;
+
+   *arg = OS_LOG_ARG_NONE;
+   *stars = 0;
+   *precision = OS_LOG_PRECISION_NONE;
+
+   while (*p != '\0' && strchr ("-+ #0", *p) != NULL)
+      p++;
+
+   if (*p == '*')
+   {
+      (*stars)++;
+      p++;
+   }
+   while (isdigit ((unsigned char)*p))
+      p++;
+
+   if (*p == '.')
+   {
+      p++;
+      if (*p == '*')
+      {
+         (*stars)++;
+         *precision = OS_LOG_PRECISION_STAR;
+         p++;
+      }
+      else
+      {
+         *precision = 0;
+         while (isdigit ((unsigned char)*p))
+         {
+            *precision = *precision * 10 + (*p - '0');
+            p++;
+         }
+      }
+   }
+
+   while (*p != '\0' && strchr ("hlLjzt", *p) != NULL)
+   {
+      if (*p == 'l')
+         length++;
+      else if (*p == 'L' || *p == 'j')
+         length = 2;
+      else if (*p == 'z' || *p == 't')
+         length = (sizeof (size_t) > sizeof (long)) ? 2 : 1;
+      p++;
+   }
+
+   switch (*p)
+   {
+   case 'd':
+   case 'i':
+   case 'u':
+   case 'x':
+   case 'X':
+   case 'o':
+   case 'c':
+      *arg = (length >= 2) ? OS_LOG_ARG_LLONG
+           : (length == 1) ? OS_LOG_ARG_LONG
+                           : OS_LOG_ARG_INT;
+      break;
+   case 'f':
+   case 'F':
+   case 'e':
+   case 'E':
+   case 'g':
+   case 'G':
+   case 'a':
+   case 'A':
+      *arg = OS_LOG_ARG_DOUBLE;
+      break;
+   case 'p':
+   case 'n':
+      *arg = OS_LOG_ARG_PTR;
+      break;
+   case 's':
+      *arg = OS_LOG_ARG_STR;
+      break;
+   case '\0':
+      return p;
+   default:
+      break;
+   }
+
+   return p + 1;
+}
+
+static bool os_log_store (
+   uint8_t * args,
+   size_t * pos,
+   const void * value,
+   size_t size)
+{
+   if (*pos + size > OS_LOG_DEFERRED_ARGS_MAX)
+   {
+      return false;
+   }
+   memcpy (&args[*pos], value, size);
+   *pos += size;
+   return true;
+}
+
+static void os_log_put (const os_log_record_t * record, const uint8_t * args)
+{
+   os_log_record_t * dst;
+   uint32_t head;
+   uint32_t offset;
+   uint32_t contiguous;
+   uint32_t pad;
+   UBaseType_t state = 0;
+   bool in_isr = xPortIsInsideInterrupt();
+
+   /* Records are short, reserve and copy with interrupts masked so that
+    * tasks and interrupts may log concurrently */
+   if (in_isr)
+      state = taskENTER_CRITICAL_FROM_ISR();
+   else
+      taskENTER_CRITICAL();
+
+   head = log_head;
+   offset = head & OS_LOG_DEFERRED_MASK;
+   contiguous = OS_LOG_DEFERRED_BUFFER_SIZE - offset;
+   pad = (contiguous < record->size) ? contiguous : 0;
+
+   if (OS_LOG_DEFERRED_BUFFER_SIZE - (head - log_tail) < pad + record->size)
+   {
+      log_dropped++;
+   }
+   else
+   {
+      /* Records never wrap, pad to the start of the buffer. A gap
+       * smaller than a record header is skipped implicitly. */
+      if (pad >= sizeof (os_log_record_t))
+      {
+         dst = (os_log_record_t *)&log_buffer[offset];
+         dst->fmt = NULL;
+         dst->size = pad;
+      }
+      head += pad;
+
+      dst = (os_log_record_t *)&log_buffer[head & OS_LOG_DEFERRED_MASK];
+      *dst = *record;
+      memcpy (dst + 1, args, record->args_size);
+
+      __atomic_store_n (&log_head, head + record->size, __ATOMIC_RELEASE);
+   }
+
+   if (in_isr)
+      taskEXIT_CRITICAL_FROM_ISR (state);
+   else
+      taskEXIT_CRITICAL();
+}
+
+static void os_log_deferred (uint8_t type, const char * fmt, ...)
+{
+   os_log_record_t record;
+   uint8_t args[OS_LOG_DEFERRED_ARGS_MAX];
+   size_t pos = 0;
+   const char * p = fmt;
+   os_log_arg_t arg;
+   int stars;
+   int precision;
+   int i;
+   va_list list;
+
+   va_start (list, fmt);
+   while ((p = strchr (p, '%')) != NULL)
+   {
+      int iv = 0;
+      long lv;
+      long long llv;
+      double dv;
+      void * pv;
+      const char * sv;
+      bool stored = true;
+
+      p = os_log_parse_spec (p + 1, &arg, &stars, &precision);
+
+      for (i = 0; i < stars && stored; i++)
+      {
+         iv = va_arg (list, int);
+         stored = os_log_store (args, &pos, &iv, sizeof (iv));
+      }
+
+      if (precision == OS_LOG_PRECISION_STAR)
+      {
+         /* Precision is the last '*' argument, negative means none */
+         precision = (iv >= 0) ? iv : OS_LOG_PRECISION_NONE;
+      }
+
+      switch (arg)
+      {
+      case OS_LOG_ARG_INT:
+         iv = va_arg (list, int);
+         stored = stored && os_log_store (args, &pos, &iv, sizeof (iv));
+         break;
+      case OS_LOG_ARG_LONG:
+         lv = va_arg (list, long);
+         stored = stored && os_log_store (args, &pos, &lv, sizeof (lv));
+         break;
+      case OS_LOG_ARG_LLONG:
+         llv = va_arg (list, long long);
+         stored = stored && os_log_store (args, &pos, &llv, sizeof (llv));
+         break;
+      case OS_LOG_ARG_DOUBLE:
+         dv = va_arg (list, double);
+         stored = stored && os_log_store (args, &pos, &dv, sizeof (dv));
+         break;
+      case OS_LOG_ARG_PTR:
+         pv = va_arg (list, void *);
+         stored = stored && os_log_store (args, &pos, &pv, sizeof (pv));
+         break;
+      case OS_LOG_ARG_STR:
+         /* The string may not outlive the call, store a copy */
+         sv = va_arg (list, const char *);
+         sv = (sv != NULL) ? sv : "(null)";
+         /* Reserve room for the terminator so that a stored string is
+          * always terminated */
+         stored = stored && pos < OS_LOG_DEFERRED_ARGS_MAX;
+         if (stored)
+         {
+            /* Like printf, never read past the precision, the string
+             * need not be terminated within it */
+            size_t max =
+               MIN (OS_LOG_DEFERRED_STR_MAX, OS_LOG_DEFERRED_ARGS_MAX - pos - 1);
+            size_t len;
+
+            if (precision >= 0)
+            {
+               max = MIN (max, (size_t)precision);
+            }
+            len = strnlen (sv, max);
+            memcpy (&args[pos], sv, len);
+            args[pos + len] = '\0';
+            pos += len + 1;
+         }
+         break;
+      case OS_LOG_ARG_NONE:
+         break;
+      }
+
+      if (!stored)
+      {
+         /* Remaining arguments are not stored, output is truncated */
+         break;
+      }
+   }
+   va_end (list);
+
+   record.tick = xPortIsInsideInterrupt() ? xTaskGetTickCountFromISR()
+                                          : xTaskGetTickCount();
+   record.fmt = fmt;
+   record.type = type;
+   record.args_size = pos;
+   record.size = OS_LOG_ALIGN (sizeof (record) + pos);
+
+   os_log_put (&record, args);
+}
+
+/* Fetch next stored argument, returns false if it was not stored */
+static bool os_log_fetch (
+   const uint8_t * args,
+   size_t args_size,
+   size_t * pos,
+   void * value,
+   size_t size)
+{
+   if (*pos + size > args_size)
+   {
+      return false;
+   }
+   memcpy (value, &args[*pos], size);
+   *pos += size;
+   return true;
+}
+
+static void os_log_print_record (const os_log_record_t * record)
+{
+   const uint8_t * args = (const uint8_t *)(record + 1);
+   const char * p = record->fmt;
+   const char * start;
+   char spec[32];
+   size_t spec_len;
+   size_t pos = 0;
+   os_log_arg_t arg;
+   int stars;
+   int precision;
+   int iv;
+
+   os_log_prefix (record->type, record->tick);
+
+   while (*p != '\0')
+   {
+      start = strchr (p, '%');
+      if (start == NULL)
+      {
+         fputs (p, stdout);
+         return;
+      }
+      fwrite (p, 1, start - p, stdout);
+
+      p = os_log_parse_spec (start + 1, &arg, &stars, &precision);
+      if (p[-1] == '%')
+      {
+         putchar ('%');
+         continue;
+      }
+
+      /* Rebuild the specification with '*' replaced by stored values */
+      spec_len = 0;
+      while (start < p && spec_len < sizeof (spec) - 12)
+      {
+         if (*start == '*')
+         {
+            if (!os_log_fetch (args, record->args_size, &pos, &iv, sizeof (iv)))
+               goto truncated;
+            if (spec_len > 0 && spec[spec_len - 1] == '.' && iv < 0)
+            {
+               /* Negative precision means no precision */
+               spec_len--;
+            }
+            else
+            {
+               spec_len += snprintf (&spec[spec_len], 12, "%d", iv);
+            }
+         }
+         else
+         {
+            spec[spec_len++] = *start;
+         }
+         start++;
+      }
+      spec[spec_len] = '\0';
+
+      switch (arg)
+      {
+      case OS_LOG_ARG_INT:
+      {
+         int v;
+         if (!os_log_fetch (args, record->args_size, &pos, &v, sizeof (v)))
+            goto truncated;
+         printf (spec, v);
+         break;
+      }
+      case OS_LOG_ARG_LONG:
+      {
+         long v;
+         if (!os_log_fetch (args, record->args_size, &pos, &v, sizeof (v)))
+            goto truncated;
+         printf (spec, v);
+         break;
+      }
+      case OS_LOG_ARG_LLONG:
+      {
+         long long v;
+         if (!os_log_fetch (args, record->args_size, &pos, &v, sizeof (v)))
+            goto truncated;
+         printf (spec, v);
+         break;
+      }
+      case OS_LOG_ARG_DOUBLE:
+      {
+         double v;
+         if (!os_log_fetch (args, record->args_size, &pos, &v, sizeof (v)))
+            goto truncated;
+         printf (spec, v);
+         break;
+      }
+      case OS_LOG_ARG_PTR:
+      {
+         void * v;
+         if (!os_log_fetch (args, record->args_size, &pos, &v, sizeof (v)))
+            goto truncated;
+         if (p[-1] == 'p')
+            printf (spec, v);
+         break;
+      }
+      case OS_LOG_ARG_STR:
+      {
+         const char * v = (const char *)&args[pos];
+         size_t len;
+         if (pos >= record->args_size)
+            goto truncated;
+         len = strnlen (v, record->args_size - pos);
+         if (len == record->args_size - pos)
+            goto truncated;
+         pos += len + 1;
+         printf (spec, v);
+         break;
+      }
+      case OS_LOG_ARG_NONE:
+         break;
+      }
+   }
+   return;
+
+truncated:
+   printf ("...\n");
+}
+
+static void os_log_deferred_task (void * arg)
+{
+   const os_log_record_t * record;
+   uint32_t tail;
+   uint32_t offset;
+   uint32_t contiguous;
+
+   for (;;)
+   {
+      tail = log_tail;
+      while (tail != __atomic_load_n (&log_head, __ATOMIC_ACQUIRE))
+      {
+         offset = tail & OS_LOG_DEFERRED_MASK;
+         contiguous = OS_LOG_DEFERRED_BUFFER_SIZE - offset;
+         if (contiguous < sizeof (os_log_record_t))
+         {
+            tail += contiguous;
+         }
+         else
+         {
+            record = (const os_log_record_t *)&log_buffer[offset];
+            if (record->fmt != NULL)
+            {
+               os_log_print_record (record);
+            }
+            tail += record->size;
+         }
+
+         /* Release the space to producers */
+         __atomic_store_n (&log_tail, tail, __ATOMIC_RELEASE);
+      }
+
+      vTaskDelay (pdMS_TO_TICKS (OS_LOG_DEFERRED_PERIOD_MS));
+   }
+}
+
+void os_log_deferred_init (void)
+{
+   os_thread_create (
+      "os_log",
+      OS_PRIORITY_LOW,
+      OS_LOG_DEFERRED_STACK_SIZE,
+      os_log_deferred_task,
+      NULL);
+
+   os_log = os_log_deferred;
+}
+
+uint32_t os_log_deferred_dropped (void)
+{
+   return log_dropped;
+}
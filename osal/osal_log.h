@@ -77,6 +77,28 @@ typedef void (*os_log_t) (uint8_t type, const char * fmt, ...) CC_FORMAT (2, 3);
 
 extern os_log_t os_log;
 
+/**
+ * Switch to deferred logging.
+ *
+ * Log calls no longer format in the caller's context. The format string
+ * pointer, a timestamp and the raw arguments are stored in a buffer and
+ * formatted later by a low priority task. String arguments are copied
+ * and truncated to OS_LOG_DEFERRED_STR_MAX characters. Messages that do
+ * not fit in the buffer are dropped.
+ *
+ * Intended to be called once during startup, after the scheduler has
+ * started.
+ */
+void os_log_deferred_init (void);
+
+/**
+ * Get number of log messages dropped because the deferred log buffer
+ * was full.
+ *
+ * @return number of dropped messages
+ */
+uint32_t os_log_deferred_dropped (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -86,7 +86,9 @@ extern "C" {
 #define CC_UNUSED(var)        (void)(var)
 
 /* modus toolbox platform not able to process default formatting
-   when printing values e.g. PRIu8 becomes hu */
+   when printing values e.g. PRIu8 becomes hu. Host builds using the
+   linux port keep the C library definitions. */
+#if !defined(__linux__)
 #undef PRIu8
 #define PRIu8 "u"
 
@@ -110,6 +112,7 @@ extern "C" {
 
 #undef PRIi64
 #define PRIi64 "lld"
+#endif
 
 #ifdef __cplusplus
 }
@@ -30,4 +30,20 @@
 #define PNET_OPTION_DRIVER_ENABLE 0
 #endif
 
+#if !defined (PNET_RT_BUF_POOL_COUNT)
+/** Number of fallback frame buffers used when the lwIP pbuf pool is
+ *  exhausted. Set to 0 to disable.
+ *
+ *  The buffers are shared by all pnal_buf_alloc() callers (PPM, DCP,
+ *  LLDP, alarms), so they are not guaranteed to be available for
+ *  cyclic frames. Requires LWIP_SUPPORT_CUSTOM_PBUF in lwipopts.h,
+ *  the build fails otherwise unless this is set to 0. */
+#define PNET_RT_BUF_POOL_COUNT 4
+#endif
+
+#if !defined (PNET_RT_BUF_POOL_SIZE)
+/** Size of each reserved frame buffer */
+#define PNET_RT_BUF_POOL_SIZE 1536
+#endif
+
 #endif  /* PNET_OPTIONS_H */
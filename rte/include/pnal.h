@@ -375,6 +375,9 @@ int pnal_eth_send (pnal_eth_handle_t * handle, pnal_buf_t * buf);
  * @param if_name          In:    Ethernet interface name
  * @param receive_type     In:    Ethernet frame types that shall be received
  *                                by the network interface / port.
+ *                                PNAL_ETHTYPE_ALL receives all frames not
+ *                                claimed by another registration on the
+ *                                same interface.
  * @param callback         In:    Callback for received raw Ethernet frames
  * @param arg              InOut: User argument passed to the callback
  *
@@ -28,6 +28,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include "osal.h"
 #include "rte_fs.h"
 
 #ifdef LFS_THREADSAFE
@@ -295,25 +296,25 @@ static RTE_FILE * fs_fopen (const char * path, const char * mode)
       flags |= LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND;
 
    fs_file_stream_t * file =
-      (fs_file_stream_t *)malloc (sizeof (fs_file_stream_t));
+      (fs_file_stream_t *)os_malloc (sizeof (fs_file_stream_t));
    if (!file)
    {
       return NULL;
    }
 
    file->lfs = &lfs;
-   file->buffer = (char *)malloc (FPRINTF_BUFFER_SIZE);
+   file->buffer = (char *)os_malloc (FPRINTF_BUFFER_SIZE);
    if (!file->buffer)
    {
-      free (file);
+      os_free (file);
       return NULL;
    }
    file->buffer_size = FPRINTF_BUFFER_SIZE;
 
    if (lfs_file_open (file->lfs, &file->file, path, flags) < 0)
    {
-      free (file->buffer);
-      free (file);
+      os_free (file->buffer);
+      os_free (file);
       return NULL;
    }
 
@@ -329,8 +330,8 @@ static int fs_fclose (RTE_FILE * file)
 
    int res = lfs_file_close (stream->lfs, &stream->file);
 
-   free (stream->buffer);
-   free (stream);
+   os_free (stream->buffer);
+   os_free (stream);
 
    return res;
 }
@@ -19,7 +19,12 @@
 #include <lwip/tcpip.h>
 
 #include "pnal.h"
+#include "osal.h"
 #include "osal_log.h"
+#include "rte_shell.h"
+
+#include <inttypes.h>
+#include <stdio.h>
 
 #define XMC72_EVK_ETHERNET_WORKAROUND
 
@@ -29,6 +34,47 @@
 
 #define MAX_NUMBER_OF_IF 1
 
+#ifndef PNAL_ETH_MAX_HANDLES
+#define PNAL_ETH_MAX_HANDLES 4
+#endif
+
+/* Receive raw (non-IP) frames in a dedicated thread instead of the lwIP
+ * tcpip thread, so that cyclic data is not delayed by IP traffic. All
+ * frames for the registered callbacks are then dispatched from this
+ * one thread, without the tcpip core lock held. Callbacks must not
+ * call lwIP functions that require the lock. pnal_eth_send() takes it
+ * itself. */
+/* Number of EtherTypes other than Profinet and LLDP that may be
+ * registered per interface */
+#ifndef PNAL_ETH_MAX_OTHER_TYPES
+#define PNAL_ETH_MAX_OTHER_TYPES 2
+#endif
+
+#ifndef PNAL_ETH_RT_RX_THREAD
+#define PNAL_ETH_RT_RX_THREAD 0
+#endif
+
+#ifndef PNAL_ETH_RT_RX_PRIORITY
+#define PNAL_ETH_RT_RX_PRIORITY OS_PRIORITY_HIGH
+#endif
+
+#ifndef PNAL_ETH_RT_RX_STACK_SIZE
+#define PNAL_ETH_RT_RX_STACK_SIZE 4096
+#endif
+
+#ifndef PNAL_ETH_RT_RX_QUEUE_SIZE
+#define PNAL_ETH_RT_RX_QUEUE_SIZE 16
+#endif
+
+/* Measure time spent waiting for the tcpip core lock when sending.
+ * Adds two clock reads per frame, enable when measuring. */
+#ifndef PNAL_ETH_TX_LOCK_STATS
+#define PNAL_ETH_TX_LOCK_STATS 0
+#endif
+
+#define PNAL_ETH_TYPE_OFFSET      12
+#define PNAL_ETH_VLAN_TYPE_OFFSET 16
+
 #if !LWIP_TCPIP_CORE_LOCKING
 #error LWIP_TCPIP_CORE_LOCKING must be enabled
 #endif
@@ -40,40 +86,157 @@
 #define PF_PNAL_LOG (LOG_STATE_ON)
 #endif
 
+/* Dispatch slots. Frequent EtherTypes get a dedicated slot so that
+ * they are dispatched without searching. Other EtherTypes are searched
+ * for in a short table. A receiver registered for PNAL_ETHTYPE_ALL
+ * only gets the frames that no other slot takes. */
+typedef enum pnal_eth_slot
+{
+   PNAL_ETH_SLOT_PROFINET,
+   PNAL_ETH_SLOT_LLDP,
+   PNAL_ETH_SLOT_ALL,
+   PNAL_ETH_SLOT_OTHER,
+   PNAL_ETH_SLOT_MAX = PNAL_ETH_SLOT_OTHER + PNAL_ETH_MAX_OTHER_TYPES,
+} pnal_eth_slot_t;
+
+static const char * const slot_name[PNAL_ETH_SLOT_OTHER] = {
+   "profinet",
+   "lldp",
+   "all",
+};
+
+struct pnal_eth_if;
+
 struct pnal_eth_handle
 {
    struct netif * netif;
+   struct pnal_eth_if * eth_if;
+   pnal_ethertype_t receive_type;
    pnal_eth_callback_t * eth_rx_callback;
    void * arg;
 };
 
-static pnal_eth_handle_t interface[MAX_NUMBER_OF_IF];
+typedef struct pnal_eth_if
+{
+   struct netif * netif;
+   pnal_eth_handle_t * slot[PNAL_ETH_SLOT_MAX];
+   uint32_t rx_frames[PNAL_ETH_SLOT_MAX];
+   uint32_t rx_unhandled[PNAL_ETH_SLOT_MAX];
+   uint32_t rx_dropped;
+   uint32_t tx_frames;
+#if PNAL_ETH_TX_LOCK_STATS
+   uint32_t tx_locks;
+   uint32_t tx_lock_wait_us;
+   uint32_t tx_lock_wait_max_us;
+#endif
+#if PNAL_ETH_RT_RX_THREAD
+   netif_input_fn input;
+   os_mbox_t * rt_mbox;
+   uint32_t rt_overruns;
+#endif
+} pnal_eth_if_t;
+
+static pnal_eth_if_t interface[MAX_NUMBER_OF_IF];
+static pnal_eth_handle_t handles[PNAL_ETH_MAX_HANDLES];
 static int nic_index = 0;
+static int handle_index = 0;
+
+/**
+ * Get dispatch slot for EtherType
+ *
+ * Other slots are filled in order and never released, so the search
+ * stops at the first free slot.
+ *
+ * @param eth_if           In:    PNAL network interface.
+ * @param type             In:    EtherType, in host byte order.
+ * @return Dispatch slot for \a type, or the free slot to register it in,
+ *         PNAL_ETH_SLOT_MAX if all other slots are taken.
+ */
+static pnal_eth_slot_t pnal_eth_type_slot (
+   const pnal_eth_if_t * eth_if,
+   uint16_t type)
+{
+   int slot;
+
+   switch (type)
+   {
+   case PNAL_ETHTYPE_PROFINET:
+      return PNAL_ETH_SLOT_PROFINET;
+   case PNAL_ETHTYPE_LLDP:
+      return PNAL_ETH_SLOT_LLDP;
+   case PNAL_ETHTYPE_ALL:
+      return PNAL_ETH_SLOT_ALL;
+   default:
+      break;
+   }
+
+   for (slot = PNAL_ETH_SLOT_OTHER; slot < PNAL_ETH_SLOT_MAX; slot++)
+   {
+      if (eth_if->slot[slot] == NULL || eth_if->slot[slot]->receive_type == type)
+      {
+         return slot;
+      }
+   }
+
+   return PNAL_ETH_SLOT_MAX;
+}
 
 /**
- * Find PNAL network interface handle
+ * Find PNAL network interface
  *
  * @param netif            In:    lwip network interface.
- * @return PNAL network interface handle corresponding to \a netif,
+ * @return PNAL network interface corresponding to \a netif,
  *         NULL otherwise.
  */
-static pnal_eth_handle_t * pnal_eth_find_handle (struct netif * netif)
+static pnal_eth_if_t * pnal_eth_find_if (struct netif * netif)
 {
-   pnal_eth_handle_t * handle;
+   pnal_eth_if_t * eth_if;
    int i;
 
-   for (i = 0; i < MAX_NUMBER_OF_IF; i++)
+   for (i = 0; i < nic_index; i++)
    {
-      handle = &interface[i];
-      if (handle->netif == netif)
+      eth_if = &interface[i];
+      if (eth_if->netif == netif)
       {
-         return handle;
+         return eth_if;
       }
    }
 
    return NULL;
 }
 
+/**
+ * Find or allocate PNAL network interface
+ *
+ * Interfaces are allocated from a static array and need never be freed.
+ *
+ * @param netif            In:    lwip network interface.
+ * @return PNAL network interface if available,
+ *         NULL if too many interfaces were allocated.
+ */
+static pnal_eth_if_t * pnal_eth_allocate_if (struct netif * netif)
+{
+   pnal_eth_if_t * eth_if;
+
+   eth_if = pnal_eth_find_if (netif);
+   if (eth_if != NULL)
+   {
+      return eth_if;
+   }
+
+   if (nic_index < MAX_NUMBER_OF_IF)
+   {
+      eth_if = &interface[nic_index];
+      eth_if->netif = netif;
+      nic_index++;
+      return eth_if;
+   }
+   else
+   {
+      return NULL;
+   }
+}
+
 /**
  * Allocate PNAL network interface handle
  *
@@ -86,10 +249,10 @@ static pnal_eth_handle_t * pnal_eth_allocate_handle (void)
 {
    pnal_eth_handle_t * handle;
 
-   if (nic_index < MAX_NUMBER_OF_IF)
+   if (handle_index < PNAL_ETH_MAX_HANDLES)
    {
-      handle = &interface[nic_index];
-      nic_index++;
+      handle = &handles[handle_index];
+      handle_index++;
       return handle;
    }
    else
@@ -98,38 +261,81 @@ static pnal_eth_handle_t * pnal_eth_allocate_handle (void)
    }
 }
 
+/**
+ * Get EtherType of Ethernet frame
+ *
+ * For VLAN tagged frames the EtherType following the tag is returned.
+ *
+ * @param p_buf            In:    Packet buffer containing Ethernet frame.
+ * @return EtherType in host byte order, 0 if frame is too short.
+ */
+static uint16_t pnal_eth_frame_type (const struct pbuf * p_buf)
+{
+   const uint8_t * frame = p_buf->payload;
+   uint16_t type;
+
+   if (p_buf->len < PNAL_ETH_TYPE_OFFSET + 2)
+   {
+      return 0;
+   }
+
+   type = PNAL_MAKEU16 (frame[PNAL_ETH_TYPE_OFFSET], frame[PNAL_ETH_TYPE_OFFSET + 1]);
+   if (type == PNAL_ETHTYPE_VLAN && p_buf->len >= PNAL_ETH_VLAN_TYPE_OFFSET + 2)
+   {
+      type = PNAL_MAKEU16 (
+         frame[PNAL_ETH_VLAN_TYPE_OFFSET],
+         frame[PNAL_ETH_VLAN_TYPE_OFFSET + 1]);
+   }
+
+   return type;
+}
 
 /**
- * Process received Ethernet frame
+ * Dispatch received Ethernet frame to its receiver
  *
- * Called from lwip when an Ethernet frame is received with an EtherType
- * lwip is not aware of (e.g. Profinet and LLDP).
+ * The frame is passed to the handle registered for its EtherType, or
+ * to the handle registered for all frames. Frames without a receiver
+ * are dropped early.
  *
+ * @param eth_if           InOut: PNAL network interface receiving the frame.
  * @param p_buf            InOut: Packet buffer containing Ethernet frame.
- * @param netif            InOut: Network interface receiving the frame.
  * @return ERR_OK if frame was processed and freed,
  *         ERR_IF if it was ignored.
  */
-static err_t pnal_eth_sys_recv (struct pbuf * p_buf, struct netif * netif)
+static err_t pnal_eth_dispatch (pnal_eth_if_t * eth_if, struct pbuf * p_buf)
 {
    int processed;
    pnal_eth_handle_t * handle;
+   pnal_eth_slot_t slot;
+   uint16_t type;
 
-   handle = pnal_eth_find_handle (netif);
+#ifdef XMC72_EVK_ETHERNET_WORKAROUND
+   /* Workaround for missing statistics implementation in infineon driver. */
+   MIB2_STATS_NETIF_INC (eth_if->netif, ifinoctets);
+#endif
+
+   type = pnal_eth_frame_type (p_buf);
+   slot = pnal_eth_type_slot (eth_if, type);
+   handle = (slot < PNAL_ETH_SLOT_MAX) ? eth_if->slot[slot] : NULL;
    if (handle == NULL)
    {
-      /* p-net not started yet, let lwIP handle frame */
+      slot = PNAL_ETH_SLOT_ALL;
+      handle = eth_if->slot[slot];
+   }
+
+   if (handle == NULL)
+   {
+      /* No receiver for this EtherType */
+      eth_if->rx_dropped++;
       return ERR_IF;
    }
 
 #ifdef XMC72_EVK_ETHERNET_WORKAROUND
    p_buf->tot_len -= 4;
    p_buf->len -= 4;
-
-   /* Workaround for missing statistics implementation in infineon driver. */
-   MIB2_STATS_NETIF_INC (netif, ifinoctets);
 #endif
 
+   eth_if->rx_frames[slot]++;
    processed = handle->eth_rx_callback (handle, handle->arg, (pnal_buf_t *)p_buf);
    if (processed)
    {
@@ -139,21 +345,159 @@ static err_t pnal_eth_sys_recv (struct pbuf * p_buf, struct netif * netif)
    else
    {
       /* Frame not handled */
+      eth_if->rx_unhandled[slot]++;
+      return ERR_IF;
+   }
+}
+
+/**
+ * Process received Ethernet frame
+ *
+ * Called from lwip when an Ethernet frame is received with an EtherType
+ * lwip is not aware of (e.g. Profinet and LLDP).
+ *
+ * @param p_buf            InOut: Packet buffer containing Ethernet frame.
+ * @param netif            InOut: Network interface receiving the frame.
+ * @return ERR_OK if frame was processed and freed,
+ *         ERR_IF if it was ignored.
+ */
+static err_t pnal_eth_sys_recv (struct pbuf * p_buf, struct netif * netif)
+{
+   pnal_eth_if_t * eth_if;
+
+   eth_if = pnal_eth_find_if (netif);
+   if (eth_if == NULL)
+   {
+      /* p-net not started yet, let lwIP handle frame */
       return ERR_IF;
    }
+
+#if PNAL_ETH_RT_RX_THREAD
+   if (eth_if->rt_mbox != NULL)
+   {
+      /* Raw frames are dispatched by the real-time receive thread only.
+       * Frames reaching lwIP were passed on as IP or ARP, let lwIP drop
+       * them. */
+      return ERR_IF;
+   }
+#endif
+
+   return pnal_eth_dispatch (eth_if, p_buf);
 }
 
+#if PNAL_ETH_RT_RX_THREAD
+
+/**
+ * Real-time receive thread
+ *
+ * Dispatches frames queued by \a pnal_eth_rt_input(). This is the only
+ * thread calling the receive callbacks and updating the receive
+ * counters once it is started.
+ *
+ * @param arg              InOut: PNAL network interface.
+ */
+static void pnal_eth_rt_task (void * arg)
+{
+   pnal_eth_if_t * eth_if = arg;
+   void * msg;
+
+   for (;;)
+   {
+      if (os_mbox_fetch (eth_if->rt_mbox, &msg, OS_WAIT_FOREVER))
+      {
+         continue;
+      }
+
+      if (pnal_eth_dispatch (eth_if, msg) != ERR_OK)
+      {
+         pbuf_free (msg);
+      }
+   }
+}
+
+/**
+ * Network interface input function
+ *
+ * Replaces netif->input, which is called by the Ethernet driver for
+ * every received frame. Untagged IP and ARP frames are passed on to
+ * lwIP. All other frames, including VLAN tagged ones, are queued to
+ * the real-time receive thread. The outer EtherType is used since
+ * tagged frames are not handled by lwIP as IP or ARP.
+ *
+ * @param p_buf            InOut: Packet buffer containing Ethernet frame.
+ * @param netif            InOut: Network interface receiving the frame.
+ * @return ERR_OK if frame was queued,
+ *         ERR_MEM if the queue was full (frame not freed),
+ *         otherwise the result of the original input function.
+ */
+static err_t pnal_eth_rt_input (struct pbuf * p_buf, struct netif * netif)
+{
+   pnal_eth_if_t * eth_if;
+   const uint8_t * frame = p_buf->payload;
+   uint16_t type = 0;
+
+   eth_if = pnal_eth_find_if (netif);
+   CC_ASSERT (eth_if != NULL);
+
+   if (p_buf->len >= PNAL_ETH_TYPE_OFFSET + 2)
+   {
+      type = PNAL_MAKEU16 (frame[PNAL_ETH_TYPE_OFFSET], frame[PNAL_ETH_TYPE_OFFSET + 1]);
+   }
+
+   switch (type)
+   {
+   case PNAL_ETHTYPE_IP:
+   case PNAL_ETHTYPE_ARP:
+      return eth_if->input (p_buf, netif);
+   default:
+      if (os_mbox_post (eth_if->rt_mbox, p_buf, 0))
+      {
+         eth_if->rt_overruns++;
+         return ERR_MEM;
+      }
+      return ERR_OK;
+   }
+}
+
+/**
+ * Start real-time receive thread for interface
+ *
+ * Must be called with the tcpip core locked.
+ *
+ * @param eth_if           InOut: PNAL network interface.
+ */
+static void pnal_eth_rt_start (pnal_eth_if_t * eth_if)
+{
+   if (eth_if->rt_mbox != NULL)
+   {
+      return;
+   }
+
+   eth_if->rt_mbox = os_mbox_create (PNAL_ETH_RT_RX_QUEUE_SIZE);
+   os_thread_create (
+      "pnal_rt_rx",
+      PNAL_ETH_RT_RX_PRIORITY,
+      PNAL_ETH_RT_RX_STACK_SIZE,
+      pnal_eth_rt_task,
+      eth_if);
+
+   eth_if->input = eth_if->netif->input;
+   eth_if->netif->input = pnal_eth_rt_input;
+}
+
+#endif /* PNAL_ETH_RT_RX_THREAD */
+
 pnal_eth_handle_t * pnal_eth_init (
    const char * if_name,
    pnal_ethertype_t receive_type,
    pnal_eth_callback_t * callback,
    void * arg)
 {
+   pnal_eth_if_t * eth_if;
    pnal_eth_handle_t * handle;
+   pnal_eth_slot_t slot;
    struct netif * netif;
 
-   (void)receive_type; /* Ignore, for now all frames will be received. */
-
    netif = netif_find (if_name);
    if (netif == NULL)
    {
@@ -161,22 +505,119 @@ pnal_eth_handle_t * pnal_eth_init (
       return NULL;
    }
 
-   handle = pnal_eth_allocate_handle();
-   if (handle == NULL)
+   LOCK_TCPIP_CORE();
+
+   eth_if = pnal_eth_allocate_if (netif);
+   if (eth_if == NULL)
    {
+      UNLOCK_TCPIP_CORE();
       os_log (LOG_LEVEL_ERROR, "Too many network interfaces\n");
       return NULL;
    }
 
-   lwip_set_hook_for_unknown_eth_protocol (netif, pnal_eth_sys_recv);
+   slot = pnal_eth_type_slot (eth_if, receive_type);
+   if (slot == PNAL_ETH_SLOT_MAX)
+   {
+      UNLOCK_TCPIP_CORE();
+      os_log (
+         LOG_LEVEL_ERROR,
+         "Too many EtherTypes on \"%s\", increase PNAL_ETH_MAX_OTHER_TYPES\n",
+         if_name);
+      return NULL;
+   }
+
+   if (eth_if->slot[slot] != NULL)
+   {
+      UNLOCK_TCPIP_CORE();
+      os_log (
+         LOG_LEVEL_ERROR,
+         "EtherType 0x%04x already registered on \"%s\"\n",
+         receive_type,
+         if_name);
+      return NULL;
+   }
+
+   handle = pnal_eth_allocate_handle();
+   if (handle == NULL)
+   {
+      UNLOCK_TCPIP_CORE();
+      os_log (LOG_LEVEL_ERROR, "Too many Ethernet handles\n");
+      return NULL;
+   }
 
    handle->arg = arg;
    handle->eth_rx_callback = callback;
+   handle->receive_type = receive_type;
    handle->netif = netif;
+   handle->eth_if = eth_if;
+
+   eth_if->slot[slot] = handle;
+   lwip_set_hook_for_unknown_eth_protocol (netif, pnal_eth_sys_recv);
+
+#if PNAL_ETH_RT_RX_THREAD
+   if (slot == PNAL_ETH_SLOT_PROFINET || slot == PNAL_ETH_SLOT_ALL)
+   {
+      pnal_eth_rt_start (eth_if);
+   }
+#endif
+
+   UNLOCK_TCPIP_CORE();
 
    return handle;
 }
 
+/**
+ * Lock tcpip core before sending
+ *
+ * The time spent waiting for the lock is accumulated in the interface
+ * statistics.
+ *
+ * @param eth_if           InOut: PNAL network interface.
+ */
+static void pnal_eth_tx_lock (pnal_eth_if_t * eth_if)
+{
+#if PNAL_ETH_TX_LOCK_STATS
+   uint32_t start = os_get_current_time_us();
+   uint32_t wait;
+
+   LOCK_TCPIP_CORE();
+
+   wait = os_get_current_time_us() - start;
+   eth_if->tx_locks++;
+   eth_if->tx_lock_wait_us += wait;
+   if (wait > eth_if->tx_lock_wait_max_us)
+   {
+      eth_if->tx_lock_wait_max_us = wait;
+   }
+#else
+   LOCK_TCPIP_CORE();
+#endif
+}
+
+/**
+ * Pass frame to driver
+ *
+ * Must be called with the tcpip core locked.
+ *
+ * @param handle           In:    Ethernet handle
+ * @param p_buf            In:    Buffer with frame to be sent
+ * @return The number of bytes sent.
+ */
+static int pnal_eth_output (pnal_eth_handle_t * handle, struct pbuf * p_buf)
+{
+#ifdef XMC72_EVK_ETHERNET_WORKAROUND
+   /* Workaround for missing statistics implementation in infineon driver. */
+   MIB2_STATS_NETIF_INC (handle->netif, ifoutoctets);
+#endif
+
+   /* TODO: remove tot_len from os_buff */
+   p_buf->tot_len = p_buf->len;
+
+   handle->netif->linkoutput (handle->netif, p_buf);
+   handle->eth_if->tx_frames++;
+   return p_buf->len;
+}
+
 /* tbd - embed timestamp to monitor elapsed time to low level driver */
 int pnal_eth_send (pnal_eth_handle_t * handle, pnal_buf_t * buf)
 {
@@ -188,18 +629,76 @@ int pnal_eth_send (pnal_eth_handle_t * handle, pnal_buf_t * buf)
    /* TODO: Determine if buf could ever be NULL here */
    if (p_buf != NULL)
    {
-#ifdef XMC72_EVK_ETHERNET_WORKAROUND
-      /* Workaround for missing statistics implementation in infineon driver. */
-      MIB2_STATS_NETIF_INC (handle->netif, ifoutoctets);
-#endif
-
-      /* TODO: remove tot_len from os_buff */
-      p_buf->tot_len = p_buf->len;
-
-      LOCK_TCPIP_CORE();
-      handle->netif->linkoutput (handle->netif, p_buf);
+      pnal_eth_tx_lock (handle->eth_if);
+      ret = pnal_eth_output (handle, p_buf);
       UNLOCK_TCPIP_CORE();
-      ret = p_buf->len;
    }
    return ret;
 }
+
+int _cmd_eth (int argc, char * argv[])
+{
+   pnal_eth_if_t * eth_if;
+   char name[8];
+   int i;
+   int slot;
+
+   for (i = 0; i < nic_index; i++)
+   {
+      eth_if = &interface[i];
+      printf ("%c%c%u:\n", eth_if->netif->name[0], eth_if->netif->name[1], eth_if->netif->num);
+      printf ("  %-10s %10s %10s\n", "rx", "frames", "unhandled");
+      for (slot = 0; slot < PNAL_ETH_SLOT_MAX; slot++)
+      {
+         if (eth_if->slot[slot] != NULL)
+         {
+            if (slot < PNAL_ETH_SLOT_OTHER)
+            {
+               snprintf (name, sizeof (name), "%s", slot_name[slot]);
+            }
+            else
+            {
+               snprintf (name, sizeof (name), "0x%04x", eth_if->slot[slot]->receive_type);
+            }
+            printf (
+               "  %-10s %10" PRIu32 " %10" PRIu32 "\n",
+               name,
+               eth_if->rx_frames[slot],
+               eth_if->rx_unhandled[slot]);
+         }
+      }
+      printf ("  %-10s %10" PRIu32 "\n", "dropped", eth_if->rx_dropped);
+#if PNAL_ETH_RT_RX_THREAD
+      printf ("  %-10s %10" PRIu32 "\n", "rt overrun", eth_if->rt_overruns);
+#endif
+      printf ("  %-10s %10" PRIu32 "\n", "tx frames", eth_if->tx_frames);
+#if PNAL_ETH_TX_LOCK_STATS
+      printf (
+         "  %-10s %10" PRIu32 " avg %" PRIu32 " max %" PRIu32 " us\n",
+         "tx locks",
+         eth_if->tx_locks,
+         (eth_if->tx_locks > 0) ? eth_if->tx_lock_wait_us / eth_if->tx_locks : 0,
+         eth_if->tx_lock_wait_max_us);
+#endif
+   }
+
+   return 0;
+}
+
+const shell_cmd_t cmd_eth = {
+   .cmd = _cmd_eth,
+   .name = "eth",
+   .help_short = "show raw Ethernet statistics",
+   .help_long =
+      "Show number of frames received per EtherType registered by the\n"
+      "protocol stack, and frames dropped because nobody subscribed.\n"
+#if PNAL_ETH_TX_LOCK_STATS
+      "Also shows frames sent and time spent waiting for the tcpip\n"
+      "core lock when sending."
+#else
+      "Also shows frames sent. Build with PNAL_ETH_TX_LOCK_STATS to\n"
+      "show time spent waiting for the tcpip core lock when sending."
+#endif
+};
+
+SHELL_CMD (cmd_eth);
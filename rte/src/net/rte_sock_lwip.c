@@ -21,6 +21,7 @@
 #include <lwip/inet.h>
 #include <string.h>
 
+#include "osal.h"
 #include "rte_sock.h"
 
 struct rte_fd_set
@@ -116,14 +117,18 @@ int rte_select (
 
 rte_fd_set_t * rte_fd_set_alloc (void)
 {
-   rte_fd_set_t * fdset = malloc (sizeof (rte_fd_set_t));
+   rte_fd_set_t * fdset = os_malloc (sizeof (rte_fd_set_t));
+   if (fdset == NULL)
+   {
+      return NULL;
+   }
    FD_CLR (0, &fdset->set);
    return (rte_fd_set_t *)fdset;
 }
 
 void rte_fd_set_free (rte_fd_set_t * set)
 {
-   free (set);
+   os_free (set);
 }
 
 void rte_fd_set_add (int fd, rte_fd_set_t * fdset)
@@ -19,6 +19,7 @@
 #include "osal.h"
 #include "osal_log.h"
 #include "rte_fs.h"
+#include "rte_shell.h"
 
 #if LWIP_IPV6
 #error "no ipv6 supported"
@@ -33,6 +34,7 @@
 #include <lwip/snmp.h>
 #include <lwip/sys.h>
 
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -45,6 +47,93 @@
 #define PF_PNAL_LOG (LOG_STATE_ON)
 #endif
 
+#if PNET_RT_BUF_POOL_COUNT > 0
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error LWIP_SUPPORT_CUSTOM_PBUF must be enabled, or PNET_RT_BUF_POOL_COUNT set to 0
+#endif
+
+/* Frame buffers reserved for the Profinet stack. They are used when
+ * the shared lwIP pbuf pool is exhausted, e.g. during a TCP burst, so
+ * that frames can still be sent. Any pnal_buf_alloc() caller may use
+ * them, DCP, LLDP and alarm traffic can exhaust them before the PPM
+ * needs one. */
+typedef struct pnal_rt_buf
+{
+   struct pbuf_custom pbuf;
+   struct pnal_rt_buf * next;
+   uint8_t data[PNET_RT_BUF_POOL_SIZE] CC_ALIGNED (4);
+} pnal_rt_buf_t;
+
+static pnal_rt_buf_t rt_buf[PNET_RT_BUF_POOL_COUNT];
+static pnal_rt_buf_t * rt_buf_free_list;
+static uint32_t rt_buf_init;
+static uint32_t rt_buf_used;
+static uint32_t rt_buf_high_water;
+static uint32_t rt_buf_failures;
+
+static void pnal_rt_buf_free (struct pbuf * p)
+{
+   pnal_rt_buf_t * buf = (pnal_rt_buf_t *)p;
+   SYS_ARCH_DECL_PROTECT (lev);
+
+   SYS_ARCH_PROTECT (lev);
+   buf->next = rt_buf_free_list;
+   rt_buf_free_list = buf;
+   rt_buf_used--;
+   SYS_ARCH_UNPROTECT (lev);
+}
+
+static struct pbuf * pnal_rt_buf_alloc (uint16_t length)
+{
+   pnal_rt_buf_t * buf = NULL;
+   SYS_ARCH_DECL_PROTECT (lev);
+
+   if (length > PNET_RT_BUF_POOL_SIZE)
+   {
+      return NULL;
+   }
+
+   SYS_ARCH_PROTECT (lev);
+   if (rt_buf_init < PNET_RT_BUF_POOL_COUNT)
+   {
+      /* Use buffers that were never allocated before the free list */
+      buf = &rt_buf[rt_buf_init++];
+   }
+   else if (rt_buf_free_list != NULL)
+   {
+      buf = rt_buf_free_list;
+      rt_buf_free_list = buf->next;
+   }
+
+   if (buf != NULL)
+   {
+      rt_buf_used++;
+      rt_buf_high_water = MAX (rt_buf_high_water, rt_buf_used);
+   }
+   else
+   {
+      rt_buf_failures++;
+   }
+   SYS_ARCH_UNPROTECT (lev);
+
+   if (buf == NULL)
+   {
+      return NULL;
+   }
+
+   buf->pbuf.custom_free_function = pnal_rt_buf_free;
+   return pbuf_alloced_custom (
+      PBUF_RAW,
+      length,
+      PBUF_REF,
+      &buf->pbuf,
+      buf->data,
+      sizeof (buf->data));
+}
+
+#endif /* PNET_RT_BUF_POOL_COUNT > 0 */
+
 int pnal_set_ip_suite (
    const char * interface_name,
    const pnal_ipaddr_t * p_ipaddr,
@@ -309,7 +398,17 @@ uint32_t pnal_get_system_uptime_10ms (void)
 
 pnal_buf_t * pnal_buf_alloc (uint16_t length)
 {
-   return (pnal_buf_t *)pbuf_alloc (PBUF_RAW, length, PBUF_POOL);
+   struct pbuf * p;
+
+   p = pbuf_alloc (PBUF_RAW, length, PBUF_POOL);
+#if PNET_RT_BUF_POOL_COUNT > 0
+   if (p == NULL)
+   {
+      p = pnal_rt_buf_alloc (length);
+   }
+#endif
+
+   return (pnal_buf_t *)p;
 }
 
 void pnal_buf_free (pnal_buf_t * p)
@@ -321,3 +420,31 @@ uint8_t pnal_buf_header (pnal_buf_t * p, int16_t header_size_increment)
 {
    return pbuf_header ((struct pbuf *)p, header_size_increment);
 }
+
+#if PNET_RT_BUF_POOL_COUNT > 0
+
+int _cmd_rtbuf (int argc, char * argv[])
+{
+   printf ("%-10s %8s %8s %8s %8s\n", "size", "blocks", "used", "max", "failed");
+   printf (
+      "%-10u %8u %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n",
+      (unsigned)PNET_RT_BUF_POOL_SIZE,
+      (unsigned)PNET_RT_BUF_POOL_COUNT,
+      rt_buf_used,
+      rt_buf_high_water,
+      rt_buf_failures);
+
+   return 0;
+}
+
+const shell_cmd_t cmd_rtbuf = {
+   .cmd = _cmd_rtbuf,
+   .name = "rtbuf",
+   .help_short = "show reserved frame buffer statistics",
+   .help_long =
+      "Show usage of the frame buffers reserved for the Profinet stack.\n"
+      "These are used when the lwIP pbuf pool is exhausted."};
+
+SHELL_CMD (cmd_rtbuf);
+
+#endif /* PNET_RT_BUF_POOL_COUNT > 0 */
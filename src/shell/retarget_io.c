@@ -44,21 +44,39 @@
 #include "retarget_io.h"
 #include "cyhal_uart.h"
 
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include <string.h>
+
 /*******************************************************************************/
 /* Macros*/
 #define ENABLE_EVENT                      1
+#define DISABLE_EVENT                     0
 #define FIFO_LEVEL                        0
 #define DEBUG_UART_RX_FIFO_EVENT_PRIORITY 63
+#define DEBUG_UART_TX_EVENT_PRIORITY      63
 
 #define RX_BUF_SZ                         64
 
+/* Upper bound for one wait for room in the transmit buffer. Several
+ * writers may wait, only one is woken per TX interrupt. */
+#define TX_WAIT_MS                        10
+
 static uint8_t uart_rx_buf[RX_BUF_SZ];
 
 /* Global Variables
 *******************************************************************************/
 RING_BUFFER_DEF (serial_buffer, SERIAL_BUFFER_SIZE);
+RING_BUFFER_DEF (serial_tx_buffer, SERIAL_TX_BUFFER_SIZE);
 
-cyhal_uart_event_callback_t UART_Isr (void)
+static volatile bool tx_enabled = false;
+static volatile bool tx_waiting = false;
+static volatile uint32_t tx_dropped = 0;
+static SemaphoreHandle_t tx_space;
+
+static void UART_Rx (void)
 {
    // Receive characters from UART and push into ringbuffer
    size_t len = RX_BUF_SZ;
@@ -67,13 +85,94 @@ cyhal_uart_event_callback_t UART_Isr (void)
          cyhal_uart_read (&cy_retarget_io_uart_obj, &uart_rx_buf, &len) &&
       len > 0)
    {
-      uint8_t * data_ptr = uart_rx_buf;
-      while (len--)
+      /* Characters that do not fit are dropped */
+      ring_buffer_put_bulk (&serial_buffer, uart_rx_buf, len);
+   }
+}
+
+/* Fill the TX FIFO from the transmit buffer. Called from the TX empty
+ * interrupt, and with interrupts locked to start a transfer. */
+static void UART_Tx (void)
+{
+   uint8_t * span;
+   size_t len;
+
+   len = ring_buffer_peek (&serial_tx_buffer, &span);
+   if (len == 0)
+   {
+      /* Nothing more to send */
+      cyhal_uart_enable_event (
+         &cy_retarget_io_uart_obj,
+         CYHAL_UART_IRQ_TX_EMPTY,
+         DEBUG_UART_TX_EVENT_PRIORITY,
+         DISABLE_EVENT);
+      return;
+   }
+
+   /* Writes as many characters as fit in the FIFO without blocking */
+   if (cyhal_uart_write (&cy_retarget_io_uart_obj, span, &len) == CY_RSLT_SUCCESS)
+   {
+      ring_buffer_consume (&serial_tx_buffer, len);
+   }
+
+   cyhal_uart_enable_event (
+      &cy_retarget_io_uart_obj,
+      CYHAL_UART_IRQ_TX_EMPTY,
+      DEBUG_UART_TX_EVENT_PRIORITY,
+      ENABLE_EVENT);
+}
+
+static void UART_Isr (void * callback_arg, cyhal_uart_event_t event)
+{
+   CY_UNUSED_PARAMETER (callback_arg);
+
+   if (event & CYHAL_UART_IRQ_RX_FIFO)
+   {
+      UART_Rx();
+   }
+
+   if (event & CYHAL_UART_IRQ_TX_EMPTY)
+   {
+      UART_Tx();
+
+      /* Wake a writer waiting for room in the transmit buffer */
+      if (tx_waiting)
       {
-         ring_buffer_put (&serial_buffer, *data_ptr++);
+         BaseType_t woken = pdFALSE;
+
+         tx_waiting = false;
+         xSemaphoreGiveFromISR (tx_space, &woken);
+         portYIELD_FROM_ISR (woken);
       }
    }
-   return 0;
+}
+
+/* Blocking is not possible in interrupt context or with interrupts
+ * masked, either by PRIMASK or by BASEPRI as in FreeRTOS critical
+ * sections. The TX interrupt would never run. */
+static bool tx_can_block (void)
+{
+   return __get_IPSR() == 0 && __get_PRIMASK() == 0 && __get_BASEPRI() == 0;
+}
+
+/* Wait until the TX interrupt has made room in the transmit buffer */
+static void tx_wait (void)
+{
+   if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+   {
+      while (ring_buffer_free (&serial_tx_buffer) == 0)
+         ;
+      return;
+   }
+
+   /* Set the flag before checking so that a TX interrupt after the
+    * check gives the semaphore */
+   tx_waiting = true;
+   if (ring_buffer_free (&serial_tx_buffer) == 0)
+   {
+      xSemaphoreTake (tx_space, pdMS_TO_TICKS (TX_WAIT_MS));
+   }
+   tx_waiting = false;
 }
 
 
@@ -94,18 +193,40 @@ void retarget_io_init (void)
 {
    serial_buffer.head = 0;
    serial_buffer.tail = 0;
+   serial_tx_buffer.head = 0;
+   serial_tx_buffer.tail = 0;
+   tx_space = xSemaphoreCreateBinary();
+   CY_ASSERT (tx_space != NULL);
    /* Enable RX_FIFO event and define the callback function when the vent occurs
     */
-   cyhal_uart_register_callback (
-      &cy_retarget_io_uart_obj,
-      (cyhal_uart_event_callback_t)UART_Isr,
-      NULL);
+   cyhal_uart_register_callback (&cy_retarget_io_uart_obj, UART_Isr, NULL);
    cyhal_uart_enable_event (
       &cy_retarget_io_uart_obj,
       CYHAL_UART_IRQ_RX_FIFO,
       DEBUG_UART_RX_FIFO_EVENT_PRIORITY,
       ENABLE_EVENT);
    Cy_SCB_SetRxFifoLevel (cy_retarget_io_uart_obj.base, FIFO_LEVEL);
+
+   /* From now on _write() queues output for the TX interrupt */
+   tx_enabled = true;
+}
+
+/*******************************************************************************
+ * Function Name: retarget_io_tx_dropped
+ ********************************************************************************
+ * Summary:
+ * Get number of characters dropped due to a full transmit buffer
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t: number of dropped characters
+ *
+ *******************************************************************************/
+uint32_t retarget_io_tx_dropped (void)
+{
+   return tx_dropped;
 }
 
 /*******************************************************************************
@@ -194,7 +315,12 @@ long _lseek (int fd, long offset, int origin)
  * Function Name: _write
  ********************************************************************************
  * Summary:
- * Functional implementation of std-library to map output to UART
+ * Functional implementation of std-library to map output to UART.
+ * Output is queued in a transmit buffer that is drained by the UART TX
+ * interrupt, so the caller does not wait for the UART. When the buffer
+ * is full RETARGET_IO_TX_OVERFLOW_POLICY selects between waiting and
+ * dropping. Waiting tasks block until the TX interrupt has made room.
+ * Output is always dropped when blocking is not possible.
  *
  * Parameters:
  *  int fd: file descriptor
@@ -208,13 +334,50 @@ long _lseek (int fd, long offset, int origin)
 int _write (int fd, const void * buf, size_t count)
 {
    CY_UNUSED_PARAMETER (fd);
+   const uint8_t * src = (const uint8_t *)buf;
+   size_t written = 0;
+   uint32_t state;
 
-   for (size_t i = 0; i < count; ++i)
+   if (!tx_enabled)
    {
-      /* Transmit single characters using UART */
-      cyhal_uart_putc (&cy_retarget_io_uart_obj, *(const uint8_t *)buf);
-      buf++;
+      /* Interrupt driven output not yet initialised */
+      for (size_t i = 0; i < count; ++i)
+      {
+         /* Transmit single characters using UART */
+         cyhal_uart_putc (&cy_retarget_io_uart_obj, src[i]);
+      }
+      return count;
    }
+
+   while (written < count)
+   {
+      /* Several tasks may print, serialise the producer side of the
+       * single-producer transmit buffer */
+      state = cyhal_system_critical_section_enter();
+      written += ring_buffer_put_bulk (
+         &serial_tx_buffer,
+         &src[written],
+         count - written);
+      UART_Tx();
+      cyhal_system_critical_section_exit (state);
+
+      if (written < count)
+      {
+         if (
+            RETARGET_IO_TX_OVERFLOW_POLICY == RETARGET_IO_TX_DROP ||
+            !tx_can_block())
+         {
+            /* Counter is also updated from interrupt context */
+            state = cyhal_system_critical_section_enter();
+            tx_dropped += count - written;
+            cyhal_system_critical_section_exit (state);
+            break;
+         }
+
+         tx_wait();
+      }
+   }
+
    return count;
 }
 
@@ -236,29 +399,42 @@ int _write (int fd, const void * buf, size_t count)
 int _read (int fd, const void * buf, size_t count)
 {
    CY_UNUSED_PARAMETER (fd);
+   uint8_t * dst = (uint8_t *)buf;
+   uint8_t * span;
+   uint8_t * cr;
+   uint32_t len;
    int char_cnt = 0;
 
-   for (size_t i = 0; i < count; ++i)
+   /* Copy contiguous spans from ringbuffer, until ringbuffer is empty. */
+   while ((size_t)char_cnt < count)
    {
-      /* Pop single characters from ringbuffer, until ringbuffer is empty. */
-      if (ring_buffer_get (&serial_buffer, (uint8_t *)buf) == RING_BUFFER_EMPTY_ERROR)
+      len = ring_buffer_peek (&serial_buffer, &span);
+      if (len == 0)
       {
          break;
       }
 
-      char_cnt++;
+      len = (len < count - char_cnt) ? len : count - char_cnt;
 
       /* Stop reading if CR (Ox0D) character is received */
+      cr = memchr (span, 0x0DU, len);
+      if (cr != NULL)
+      {
+         len = cr - span + 1;
+      }
+
+      memcpy (&dst[char_cnt], span, len);
+      ring_buffer_consume (&serial_buffer, len);
+      char_cnt += len;
+
       /* New line character (CR) received ? */
-      if (*(uint8_t *)buf == 0x0DU)
+      if (cr != NULL)
       {
          /* Yes, convert LF to '\n' char. */
-         *(uint8_t *)buf = '\n';
+         dst[char_cnt - 1] = '\n';
          /* Stop loop and return received char(s) */
          break;
       }
-
-      buf++;
    }
 
    return char_cnt;
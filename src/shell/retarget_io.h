@@ -48,6 +48,20 @@
  *******************************************************************************/
 #define SERIAL_BUFFER_SIZE 128
 
+/* Size of the transmit buffer drained by the UART TX interrupt.
+ * Must be a power of two. */
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 1024
+#endif
+
+/* Transmit buffer overflow policies */
+#define RETARGET_IO_TX_BLOCK 0 /* Wait for space, never lose output */
+#define RETARGET_IO_TX_DROP  1 /* Drop and count characters that do not fit */
+
+#ifndef RETARGET_IO_TX_OVERFLOW_POLICY
+#define RETARGET_IO_TX_OVERFLOW_POLICY RETARGET_IO_TX_BLOCK
+#endif
+
 /*******************************************************************************
  * Global variables
  *******************************************************************************/
@@ -62,6 +76,9 @@ extern "C" {
  *******************************************************************************/
 void retarget_io_init (void);
 
+/* Number of characters dropped because the transmit buffer was full */
+uint32_t retarget_io_tx_dropped (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,66 +40,55 @@
 
 #include "ring_buffer.h"
 
+#include <string.h>
+
 /*******************************************************************************
- * Function Name: ring_buffer_is_empty
- ********************************************************************************
- * Summary:
- * Check if ringbuffer is empty
- *
- * Parameters:
- *  ring_buffer_t *const rb: Pointer to ring buffer
- *
- * Return:
- *  bool: RING_BUFFER_EMPTY     - if ring buffer is empty
- *        RING_BUFFER_NOT_EMPTY - if ring buffer is not empty
- *
+ * Macros
  *******************************************************************************/
-static bool ring_buffer_is_empty (ring_buffer_t * const rb)
-{
-   uint32_t head = rb->head;
-   uint32_t tail = rb->tail;
-   return (head == tail);
-}
+/* Producer and consumer only share head and tail. Acquire/release
+ * ordering guarantees that buffer contents are visible before the
+ * index that publishes them, also on cores with weak memory ordering. */
+#define RB_LOAD_ACQUIRE(p)     __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define RB_STORE_RELEASE(p, v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+
+#define RB_MIN(a, b) (((a) < (b)) ? (a) : (b))
 
 /*******************************************************************************
- * Function Name: ring_buffer_is_full
+ * Function Name: ring_buffer_avail
  ********************************************************************************
  * Summary:
- * Check if ringbuffer is full
+ * Number of bytes available for reading from the ring buffer
  *
  * Parameters:
  *  ring_buffer_t *const rb: Pointer to ring buffer
  *
  * Return:
- *  bool: RING_BUFFER_FULL      - if ring buffer is full
- *        RING_BUFFER_NOT_FULL  - if ring buffer is not full
+ *  uint32_t: number of bytes that can be read
  *
  *******************************************************************************/
-static bool ring_buffer_is_full (ring_buffer_t * const rb)
+uint32_t ring_buffer_avail (ring_buffer_t * const rb)
 {
-   uint32_t head = rb->head;
-   uint32_t tail = rb->tail;
-   return (((head + 1) % rb->len) == tail);
+   uint32_t head = RB_LOAD_ACQUIRE (&rb->head);
+   uint32_t tail = RB_LOAD_ACQUIRE (&rb->tail);
+   return head - tail;
 }
 
 /*******************************************************************************
- * Function Name: ring_buffer_avail
+ * Function Name: ring_buffer_free
  ********************************************************************************
  * Summary:
- * Check for available space inside ring buffer
+ * Check for free space inside ring buffer
  *
  * Parameters:
  *  ring_buffer_t *const rb: Pointer to ring buffer
  *
  * Return:
- *  uint32_t: available space
+ *  uint32_t: number of bytes that can be written
  *
  *******************************************************************************/
-uint32_t ring_buffer_avail (ring_buffer_t * const rb)
+uint32_t ring_buffer_free (ring_buffer_t * const rb)
 {
-   uint32_t head = rb->head;
-   uint32_t tail = rb->tail;
-   return (head - tail) % rb->len;
+   return rb->len - ring_buffer_avail (rb);
 }
 
 /*******************************************************************************
@@ -119,13 +108,16 @@ uint32_t ring_buffer_avail (ring_buffer_t * const rb)
  *******************************************************************************/
 int32_t ring_buffer_put (ring_buffer_t * const rb, uint8_t c)
 {
-   if (ring_buffer_is_full (rb))
+   uint32_t head = rb->head;
+   uint32_t tail = RB_LOAD_ACQUIRE (&rb->tail);
+
+   if (head - tail == rb->len)
    {
       return RING_BUFFER_FULL_ERROR;
    }
 
-   rb->buffer[rb->head] = c;
-   rb->head = (rb->head + 1) % rb->len;
+   rb->buffer[head & (rb->len - 1)] = c;
+   RB_STORE_RELEASE (&rb->head, head + 1);
 
    return RING_BUFFER_OK;
 }
@@ -147,15 +139,180 @@ int32_t ring_buffer_put (ring_buffer_t * const rb, uint8_t c)
  *******************************************************************************/
 int32_t ring_buffer_get (ring_buffer_t * const rb, uint8_t * const c)
 {
-   if (ring_buffer_is_empty (rb))
+   uint32_t tail = rb->tail;
+   uint32_t head = RB_LOAD_ACQUIRE (&rb->head);
+
+   if (head == tail)
    {
       return RING_BUFFER_EMPTY_ERROR;
    }
 
-   *c = rb->buffer[rb->tail];
-   rb->tail = (rb->tail + 1) % rb->len;
+   *c = rb->buffer[tail & (rb->len - 1)];
+   RB_STORE_RELEASE (&rb->tail, tail + 1);
 
    return RING_BUFFER_OK;
 }
 
+/*******************************************************************************
+ * Function Name: ring_buffer_reserve
+ ********************************************************************************
+ * Summary:
+ * Get the largest contiguous span that can be written without wrapping.
+ * The data is published by a following call to ring_buffer_commit().
+ * Only to be called by the producer.
+ *
+ * Parameters:
+ *  ring_buffer_t *const rb: Pointer to ring buffer
+ *  uint8_t **data: Set to start of writable span
+ *
+ * Return:
+ *  uint32_t: size of writable span, 0 if ring buffer is full
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_reserve (ring_buffer_t * const rb, uint8_t ** data)
+{
+   uint32_t head = rb->head;
+   uint32_t tail = RB_LOAD_ACQUIRE (&rb->tail);
+   uint32_t offset = head & (rb->len - 1);
+
+   *data = &rb->buffer[offset];
+   return RB_MIN (rb->len - (head - tail), rb->len - offset);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_commit
+ ********************************************************************************
+ * Summary:
+ * Publish bytes written to a span returned by ring_buffer_reserve()
+ *
+ * Parameters:
+ *  ring_buffer_t *const rb: Pointer to ring buffer
+ *  uint32_t len: Number of bytes written, at most the reserved size
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ring_buffer_commit (ring_buffer_t * const rb, uint32_t len)
+{
+   RB_STORE_RELEASE (&rb->head, rb->head + len);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_peek
+ ********************************************************************************
+ * Summary:
+ * Get the largest contiguous span that can be read without wrapping.
+ * The data is released by a following call to ring_buffer_consume().
+ * Only to be called by the consumer.
+ *
+ * Parameters:
+ *  ring_buffer_t *const rb: Pointer to ring buffer
+ *  uint8_t **data: Set to start of readable span
+ *
+ * Return:
+ *  uint32_t: size of readable span, 0 if ring buffer is empty
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_peek (ring_buffer_t * const rb, uint8_t ** data)
+{
+   uint32_t tail = rb->tail;
+   uint32_t head = RB_LOAD_ACQUIRE (&rb->head);
+   uint32_t offset = tail & (rb->len - 1);
+
+   *data = &rb->buffer[offset];
+   return RB_MIN (head - tail, rb->len - offset);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_consume
+ ********************************************************************************
+ * Summary:
+ * Release bytes read from a span returned by ring_buffer_peek()
+ *
+ * Parameters:
+ *  ring_buffer_t *const rb: Pointer to ring buffer
+ *  uint32_t len: Number of bytes read, at most the peeked size
+ *
+ * Return:
+ *  void
+ *
+ *******************************************************************************/
+void ring_buffer_consume (ring_buffer_t * const rb, uint32_t len)
+{
+   RB_STORE_RELEASE (&rb->tail, rb->tail + len);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_put_bulk
+ ********************************************************************************
+ * Summary:
+ * Push a block of data into ringbuffer. Data that does not fit is
+ * dropped.
+ *
+ * Parameters:
+ *  ring_buffer_t *const rb: Pointer to ring buffer
+ *  const uint8_t *data: Data to put into ring buffer
+ *  uint32_t len: Number of bytes in data
+ *
+ * Return:
+ *  uint32_t: number of bytes put into ring buffer
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_put_bulk (
+   ring_buffer_t * const rb,
+   const uint8_t * data,
+   uint32_t len)
+{
+   uint32_t head = rb->head;
+   uint32_t tail = RB_LOAD_ACQUIRE (&rb->tail);
+   uint32_t offset = head & (rb->len - 1);
+   uint32_t first;
+
+   len = RB_MIN (len, rb->len - (head - tail));
+
+   /* Copy in at most two parts, up to the end of the buffer and from
+    * the start of the buffer */
+   first = RB_MIN (len, rb->len - offset);
+   memcpy (&rb->buffer[offset], data, first);
+   memcpy (&rb->buffer[0], data + first, len - first);
+
+   RB_STORE_RELEASE (&rb->head, head + len);
+
+   return len;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_get_bulk
+ ********************************************************************************
+ * Summary:
+ * Pop a block of data from ringbuffer
+ *
+ * Parameters:
+ *  ring_buffer_t *const rb: Pointer to ring buffer
+ *  uint8_t *data: Buffer for data popped from ring buffer
+ *  uint32_t len: Size of data buffer
+ *
+ * Return:
+ *  uint32_t: number of bytes popped from ring buffer
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_get_bulk (ring_buffer_t * const rb, uint8_t * data, uint32_t len)
+{
+   uint32_t tail = rb->tail;
+   uint32_t head = RB_LOAD_ACQUIRE (&rb->head);
+   uint32_t offset = tail & (rb->len - 1);
+   uint32_t first;
+
+   len = RB_MIN (len, head - tail);
+
+   first = RB_MIN (len, rb->len - offset);
+   memcpy (data, &rb->buffer[offset], first);
+   memcpy (data + first, &rb->buffer[0], len - first);
+
+   RB_STORE_RELEASE (&rb->tail, tail + len);
+
+   return len;
+}
+
 /* [] END OF FILE */
@@ -47,7 +47,12 @@
 /*******************************************************************************
  * Macros
  *******************************************************************************/
+/* The size must be a power of two. Head and tail are free-running
+ * indices that are masked on access, so all sz bytes are usable. */
 #define RING_BUFFER_DEF(x, sz)                                                 \
+   _Static_assert (                                                            \
+      ((sz) != 0) && (((sz) & ((sz)-1)) == 0),                                 \
+      "ring buffer size must be a power of two");                              \
    uint8_t x##_data[sz];                                                       \
    ring_buffer_t x = {.buffer = x##_data, .head = 0, .tail = 0, .len = sz}
 
@@ -63,6 +68,9 @@
 /*******************************************************************************
  * Typedefs
  *******************************************************************************/
+/* Lock-free for one producer (e.g. an ISR) and one consumer (e.g. a
+ * task). The producer only writes head, the consumer only writes
+ * tail. */
 typedef struct ring_buffer
 {
    uint8_t * buffer;
@@ -75,9 +83,25 @@ typedef struct ring_buffer
  * Function prototypes
  *******************************************************************************/
 uint32_t ring_buffer_avail (ring_buffer_t * const rb);
+uint32_t ring_buffer_free (ring_buffer_t * const rb);
 int32_t ring_buffer_put (ring_buffer_t * const rb, uint8_t c);
 int32_t ring_buffer_get (ring_buffer_t * const rb, uint8_t * const c);
 
+/* Bulk transfers, return the number of bytes copied */
+uint32_t ring_buffer_put_bulk (
+   ring_buffer_t * const rb,
+   const uint8_t * data,
+   uint32_t len);
+uint32_t ring_buffer_get_bulk (ring_buffer_t * const rb, uint8_t * data, uint32_t len);
+
+/* Contiguous-span access without intermediate copies (consumer side) */
+uint32_t ring_buffer_peek (ring_buffer_t * const rb, uint8_t ** data);
+void ring_buffer_consume (ring_buffer_t * const rb, uint32_t len);
+
+/* Contiguous-span access without intermediate copies (producer side) */
+uint32_t ring_buffer_reserve (ring_buffer_t * const rb, uint8_t ** data);
+void ring_buffer_commit (ring_buffer_t * const rb, uint32_t len);
+
 #endif
 
 /* [] END OF FILE */
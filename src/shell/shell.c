@@ -55,6 +55,7 @@
 
 #include "osal.h"
 #include "rte_shell.h"
+#include "utils.h"
 
 /*******************************************************************************
  * Typedefs
@@ -381,6 +382,7 @@ void shell_console_init (void)
    CY_ASSERT (result == CY_RSLT_SUCCESS);
 
    retarget_io_init();
+   utils_hires_timer_init();
 
    /* initialize shell console */
    shell_init (my_shell_init);
@@ -11,12 +11,30 @@
  ********************************************************************/
 
 #include "cyhal_wdt.h"
+#include "cyhal_timer.h"
+#include "cyhal_system.h"
+#include "osal.h"
 #include "shell.h"
 #include "utils.h"
+#include <FreeRTOS.h>
+#include <task.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 
+#if UTILS_HIRES_TIMER
+
+#define HIRES_TIMER_FREQUENCY_HZ 1000000u
+#define HIRES_TIMER_PERIOD       0xFFFFu /* fits 16- and 32-bit counters */
+#define HIRES_TIMER_IRQ_PRIORITY 3u
+
+static cyhal_timer_t hires_timer;
+static volatile uint32_t hires_timer_high;
+static volatile bool hires_timer_running;
+
+#endif
+
 /**
  * Override the OSAL system reset function.
  * os_system_reset() is defined with a weak attribute in the OSAL
@@ -27,6 +45,122 @@ void os_system_reset (void)
    NVIC_SystemReset();
 }
 
+#if UTILS_HIRES_TIMER
+
+static void hires_timer_isr (void * arg, cyhal_timer_event_t event)
+{
+   CY_UNUSED_PARAMETER (arg);
+   CY_UNUSED_PARAMETER (event);
+
+   /* Extend the counter to 32 bits */
+   hires_timer_high += HIRES_TIMER_PERIOD + 1;
+}
+
+static bool hires_timer_wrap_pending (void)
+{
+   uint32_t cnt = hires_timer.tcpwm.resource.channel_num;
+
+#if defined(CY_IP_MXTCPWM) && (CY_IP_MXTCPWM_VERSION >= 2)
+   /* The PDL addresses TCPWM v2 counters as (group << 8) | counter */
+   cnt |= (uint32_t)hires_timer.tcpwm.resource.block_num << 8;
+#endif
+
+   return (Cy_TCPWM_GetInterruptStatus (hires_timer.tcpwm.base, cnt) &
+           CY_TCPWM_INT_ON_TC) != 0;
+}
+
+bool utils_hires_timer_init (void)
+{
+   const cyhal_timer_cfg_t cfg = {
+      .compare_value = 0,
+      .period = HIRES_TIMER_PERIOD,
+      .direction = CYHAL_TIMER_DIR_UP,
+      .is_compare = false,
+      .is_continuous = true,
+      .value = 0};
+
+   if (hires_timer_running)
+   {
+      return true;
+   }
+
+   if (cyhal_timer_init (&hires_timer, NC, NULL) != CY_RSLT_SUCCESS)
+   {
+      return false;
+   }
+
+   if (
+      cyhal_timer_configure (&hires_timer, &cfg) != CY_RSLT_SUCCESS ||
+      cyhal_timer_set_frequency (&hires_timer, HIRES_TIMER_FREQUENCY_HZ) !=
+         CY_RSLT_SUCCESS)
+   {
+      cyhal_timer_free (&hires_timer);
+      return false;
+   }
+
+   cyhal_timer_register_callback (&hires_timer, hires_timer_isr, NULL);
+   cyhal_timer_enable_event (
+      &hires_timer,
+      CYHAL_TIMER_IRQ_TERMINAL_COUNT,
+      HIRES_TIMER_IRQ_PRIORITY,
+      true);
+
+   if (cyhal_timer_start (&hires_timer) != CY_RSLT_SUCCESS)
+   {
+      cyhal_timer_free (&hires_timer);
+      return false;
+   }
+
+   hires_timer_running = true;
+   return true;
+}
+
+/**
+ * Override the OSAL time function with a microsecond resolution clock.
+ * os_get_current_time_us() is defined with a weak attribute in the OSAL
+ * implementation.
+ *
+ * Until utils_hires_timer_init() has started the counter, or if it
+ * failed, the tick based time is returned. A wrap that has not yet
+ * been serviced by the interrupt is detected from the pending terminal
+ * count flag. The time is only off if interrupts are masked for longer
+ * than two counter periods (131 ms).
+ */
+uint32_t os_get_current_time_us (void)
+{
+   uint32_t high;
+   uint32_t count;
+   uint32_t state;
+
+   if (!hires_timer_running)
+   {
+      return 1000 * (xTaskGetTickCount() * portTICK_PERIOD_MS);
+   }
+
+   state = cyhal_system_critical_section_enter();
+   high = hires_timer_high;
+   count = cyhal_timer_read (&hires_timer);
+   if (hires_timer_wrap_pending())
+   {
+      /* Counter wrapped but the interrupt has not run yet. Read again,
+       * the first value may be from before the wrap. */
+      count = cyhal_timer_read (&hires_timer);
+      high += HIRES_TIMER_PERIOD + 1;
+   }
+   cyhal_system_critical_section_exit (state);
+
+   return high + count;
+}
+
+#else
+
+bool utils_hires_timer_init (void)
+{
+   return false;
+}
+
+#endif /* UTILS_HIRES_TIMER */
+
 int _cmd_reboot (int argc, char * argv[])
 {
    os_system_reset();
@@ -40,3 +174,63 @@ const shell_cmd_t cmd_reboot = {
    .help_long = "Trigger a system reset using the hw watchdog."};
 
 SHELL_CMD (cmd_reboot);
+
+int _cmd_mem (int argc, char * argv[])
+{
+   os_pool_stats_t stats[8];
+   size_t n;
+   size_t ix;
+
+   n = os_malloc_stats (stats, NELEMENTS (stats));
+   n = MIN (n, NELEMENTS (stats));
+
+   printf (
+      "%-10s %8s %8s %8s %8s %8s\n",
+      "pool",
+      "blocks",
+      "used",
+      "max",
+      "spilled",
+      "failed");
+   for (ix = 0; ix < n; ix++)
+   {
+      if (stats[ix].block_size == 0)
+      {
+         /* Heap blocks may be released with free(), usage is unknown */
+         printf (
+            "%-10s %8s %8s %8s %8s %8" PRIu32 "\n",
+            "heap",
+            "-",
+            "-",
+            "-",
+            "-",
+            stats[ix].failures);
+      }
+      else
+      {
+         printf (
+            "%-10u %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8s\n",
+            (unsigned)stats[ix].block_size,
+            stats[ix].blocks,
+            stats[ix].used,
+            stats[ix].high_water,
+            stats[ix].spills,
+            "-");
+      }
+   }
+
+   return 0;
+}
+
+const shell_cmd_t cmd_mem = {
+   .cmd = _cmd_mem,
+   .name = "mem",
+   .help_short = "show os_malloc statistics",
+   .help_long =
+      "Show block size, number of blocks, current and max usage for each\n"
+      "os_malloc pool, and how many requests spilled to a larger pool or\n"
+      "the heap because the pool was empty. For the heap only failed\n"
+      "os_malloc calls are shown, usage is not tracked since the stack\n"
+      "library releases heap blocks with free()."};
+
+SHELL_CMD (cmd_mem);
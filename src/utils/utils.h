@@ -13,16 +13,35 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* When enabled, os_get_current_time_us() is overridden with a 1 MHz
+ * clock from a TCPWM counter, started by utils_hires_timer_init().
+ * Otherwise the tick based OSAL default is used. Combine with
+ * OSAL_USLEEP_HYBRID for sub-tick os_usleep(). */
+#ifndef UTILS_HIRES_TIMER
+#define UTILS_HIRES_TIMER 0
+#endif
+
 /**
  * Reset the system.
  * This function will not return.
  */
 void utils_reset (void);
 
+/**
+ * Start the microsecond clock used by os_get_current_time_us().
+ * Call once at startup, from thread context. Does nothing unless
+ * UTILS_HIRES_TIMER is enabled.
+ *
+ * @return true if the clock is running, false otherwise
+ */
+bool utils_hires_timer_init (void);
+
 #ifdef __cplusplus
 }
 #endif
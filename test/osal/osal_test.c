@@ -0,0 +1,182 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * http://www.rt-labs.com
+ * Copyright 2024 rt-labs AB, Sweden.
+ * See LICENSE file in the project root for full license information.
+ ********************************************************************/
+
+/*
+ * Smoke test for the Linux OSAL port in osal/linux. Checks that the
+ * semantics match the FreeRTOS port in osal/osal.c. Build and run with
+ * "make -C test check".
+ */
+
+#include "osal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond)                                                            \
+   do                                                                          \
+   {                                                                           \
+      if (!(cond))                                                             \
+      {                                                                        \
+         printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+         failures++;                                                           \
+      }                                                                        \
+   } while (0)
+
+static int failures;
+
+static void test_mutex (void)
+{
+   os_mutex_t * mutex = os_mutex_create();
+
+   /* Mutexes are recursive */
+   os_mutex_lock (mutex);
+   os_mutex_lock (mutex);
+   os_mutex_unlock (mutex);
+   os_mutex_unlock (mutex);
+
+   os_mutex_destroy (mutex);
+}
+
+static void sem_signal_task (void * arg)
+{
+   os_usleep (10 * 1000);
+   os_sem_signal (arg);
+}
+
+static void test_sem (void)
+{
+   os_sem_t * sem = os_sem_create (1);
+   uint32_t start;
+
+   /* Returns false when taken, true on timeout */
+   CHECK (os_sem_wait (sem, 0) == false);
+
+   start = os_get_current_time_us();
+   CHECK (os_sem_wait (sem, 20) == true);
+   CHECK (os_get_current_time_us() - start >= 20 * 1000);
+
+   os_thread_create ("sem", OS_PRIORITY_NORMAL, 0, sem_signal_task, sem);
+   CHECK (os_sem_wait (sem, 1000) == false);
+
+   os_sem_destroy (sem);
+}
+
+static void event_set_task (void * arg)
+{
+   os_usleep (10 * 1000);
+   os_event_set (arg, BIT (3));
+}
+
+static void test_event (void)
+{
+   os_event_t * event = os_event_create();
+   uint32_t value = 0xFFFFFFFF;
+
+   /* Returns true when any bit in mask is set, false on timeout */
+   CHECK (os_event_wait (event, BIT (0), &value, 10) == false);
+   CHECK (value == 0);
+
+   os_thread_create ("event", OS_PRIORITY_NORMAL, 0, event_set_task, event);
+   CHECK (os_event_wait (event, BIT (3) | BIT (4), &value, 1000) == true);
+   CHECK (value == BIT (3));
+
+   /* Bits are not cleared by waiting */
+   CHECK (os_event_wait (event, BIT (3), &value, 0) == true);
+   os_event_clr (event, BIT (3));
+   CHECK (os_event_wait (event, BIT (3), &value, 0) == false);
+
+   os_event_destroy (event);
+}
+
+static void test_mbox (void)
+{
+   os_mbox_t * mbox = os_mbox_create (2);
+   void * msg = NULL;
+
+   /* Returns false on success, true on timeout */
+   CHECK (os_mbox_fetch (mbox, &msg, 10) == true);
+
+   CHECK (os_mbox_post (mbox, (void *)1, 0) == false);
+   CHECK (os_mbox_post (mbox, (void *)2, 0) == false);
+   CHECK (os_mbox_post (mbox, (void *)3, 10) == true);
+
+   CHECK (os_mbox_fetch (mbox, &msg, 0) == false);
+   CHECK (msg == (void *)1);
+   CHECK (os_mbox_fetch (mbox, &msg, 0) == false);
+   CHECK (msg == (void *)2);
+
+   os_mbox_destroy (mbox);
+}
+
+static void timer_fn (os_timer_t * timer, void * arg)
+{
+   os_sem_signal (arg);
+}
+
+static int timer_count (os_sem_t * sem)
+{
+   int count = 0;
+
+   while (os_sem_wait (sem, 0) == false)
+   {
+      count++;
+   }
+   return count;
+}
+
+static void test_timer (void)
+{
+   os_sem_t * sem = os_sem_create (0);
+   os_timer_t * timer;
+   int count;
+
+   timer = os_timer_create (10 * 1000, timer_fn, sem, false);
+   os_timer_start (timer);
+   os_usleep (105 * 1000);
+   os_timer_stop (timer);
+   count = timer_count (sem);
+   CHECK (count >= 8 && count <= 11);
+
+   /* No expiries after stop */
+   os_usleep (30 * 1000);
+   CHECK (timer_count (sem) == 0);
+   os_timer_destroy (timer);
+
+   timer = os_timer_create (10 * 1000, timer_fn, sem, true);
+   os_timer_start (timer);
+   os_usleep (50 * 1000);
+   CHECK (timer_count (sem) == 1);
+   os_timer_destroy (timer);
+
+   os_sem_destroy (sem);
+}
+
+static void test_time (void)
+{
+   os_tick_t start = os_tick_current();
+
+   os_tick_sleep (os_tick_from_us (5000));
+   CHECK (os_tick_current() - start >= os_tick_from_us (5000));
+}
+
+int main (void)
+{
+   test_mutex();
+   test_sem();
+   test_event();
+   test_mbox();
+   test_timer();
+   test_time();
+
+   printf ("osal_test: %s\n", (failures == 0) ? "ok" : "FAILED");
+   return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,231 @@
+/*********************************************************************
+ *        _       _         _
+ *  _ __ | |_  _ | |  __ _ | |__   ___
+ * | '__|| __|(_)| | / _` || '_ \ / __|
+ * | |   | |_  _ | || (_| || |_) |\__ \
+ * |_|    \__|(_)|_| \__,_||_.__/ |___/
+ *
+ * http://www.rt-labs.com
+ * Copyright 2024 rt-labs AB, Sweden.
+ * See LICENSE file in the project root for full license information.
+ ********************************************************************/
+
+/*
+ * Host benchmark and SPSC stress test for src/shell/ring_buffer.c.
+ *
+ * Compares the previous modulo-indexed ring buffer (copied below) with
+ * the current implementation. Build and run on the host with
+ * "make -C test bench".
+ *
+ * The "isr" figures time one 16-byte burst, the size of the UART
+ * FIFO drained per interrupt, and approximate the per-interrupt cost.
+ */
+
+#include "ring_buffer.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BUFFER_SIZE  1024
+#define BURST_SIZE   16
+#define BENCH_BYTES  (64u * 1024 * 1024)
+#define STRESS_BYTES (16u * 1024 * 1024)
+
+/* Previous implementation, kept for comparison */
+
+typedef struct old_ring_buffer
+{
+   uint8_t * buffer;
+   volatile uint32_t head;
+   volatile uint32_t tail;
+   const uint32_t len;
+} old_ring_buffer_t;
+
+static int32_t old_ring_buffer_put (old_ring_buffer_t * const rb, uint8_t c)
+{
+   if (((rb->head + 1) % rb->len) == rb->tail)
+   {
+      return RING_BUFFER_FULL_ERROR;
+   }
+
+   rb->buffer[rb->head] = c;
+   rb->head = (rb->head + 1) % rb->len;
+
+   return RING_BUFFER_OK;
+}
+
+static int32_t old_ring_buffer_get (old_ring_buffer_t * const rb, uint8_t * const c)
+{
+   if (rb->head == rb->tail)
+   {
+      return RING_BUFFER_EMPTY_ERROR;
+   }
+
+   *c = rb->buffer[rb->tail];
+   rb->tail = (rb->tail + 1) % rb->len;
+
+   return RING_BUFFER_OK;
+}
+
+static uint8_t old_data[BUFFER_SIZE];
+static old_ring_buffer_t old_rb = {.buffer = old_data, .len = BUFFER_SIZE};
+
+RING_BUFFER_DEF (new_rb, BUFFER_SIZE);
+
+static volatile uint32_t sink;
+
+static uint64_t now_ns (void)
+{
+   struct timespec ts;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void report (const char * name, uint64_t ns, uint64_t bursts)
+{
+   printf (
+      "%-10s %8.1f MB/s  isr %6.1f ns\n",
+      name,
+      (double)BENCH_BYTES * 1000.0 / (double)ns,
+      (double)ns / (double)bursts / 2.0);
+}
+
+static void bench_old (void)
+{
+   uint64_t start = now_ns();
+   uint32_t n;
+   uint32_t i;
+   uint8_t c = 0;
+
+   for (n = 0; n < BENCH_BYTES; n += BURST_SIZE)
+   {
+      for (i = 0; i < BURST_SIZE; i++)
+      {
+         old_ring_buffer_put (&old_rb, (uint8_t)i);
+      }
+      for (i = 0; i < BURST_SIZE; i++)
+      {
+         old_ring_buffer_get (&old_rb, &c);
+         sink += c;
+      }
+   }
+
+   report ("old byte", now_ns() - start, BENCH_BYTES / BURST_SIZE);
+}
+
+static void bench_new_byte (void)
+{
+   uint64_t start = now_ns();
+   uint32_t n;
+   uint32_t i;
+   uint8_t c = 0;
+
+   for (n = 0; n < BENCH_BYTES; n += BURST_SIZE)
+   {
+      for (i = 0; i < BURST_SIZE; i++)
+      {
+         ring_buffer_put (&new_rb, (uint8_t)i);
+      }
+      for (i = 0; i < BURST_SIZE; i++)
+      {
+         ring_buffer_get (&new_rb, &c);
+         sink += c;
+      }
+   }
+
+   report ("new byte", now_ns() - start, BENCH_BYTES / BURST_SIZE);
+}
+
+static void bench_new_bulk (void)
+{
+   uint64_t start = now_ns();
+   uint8_t in[BURST_SIZE] = {0};
+   uint8_t out[BURST_SIZE];
+   uint32_t n;
+
+   for (n = 0; n < BENCH_BYTES; n += BURST_SIZE)
+   {
+      in[0] = (uint8_t)n;
+      ring_buffer_put_bulk (&new_rb, in, BURST_SIZE);
+      ring_buffer_get_bulk (&new_rb, out, BURST_SIZE);
+      sink += out[0];
+   }
+
+   report ("new bulk", now_ns() - start, BENCH_BYTES / BURST_SIZE);
+}
+
+static void * stress_producer (void * arg)
+{
+   uint8_t data[BURST_SIZE];
+   uint32_t sent = 0;
+   uint32_t len;
+   uint32_t i;
+
+   (void)arg;
+
+   while (sent < STRESS_BYTES)
+   {
+      len = 1 + (sent % BURST_SIZE);
+      for (i = 0; i < len; i++)
+      {
+         data[i] = (uint8_t)(sent + i);
+      }
+      /* Bytes not accepted are sent again with the same values */
+      len = ring_buffer_put_bulk (&new_rb, data, len);
+      if (len == 0)
+      {
+         sched_yield();
+      }
+      sent += len;
+   }
+
+   return NULL;
+}
+
+static int stress (void)
+{
+   pthread_t producer;
+   uint32_t received = 0;
+   uint8_t * span;
+   uint32_t len;
+   uint32_t i;
+
+   pthread_create (&producer, NULL, stress_producer, NULL);
+
+   while (received < STRESS_BYTES)
+   {
+      len = ring_buffer_peek (&new_rb, &span);
+      for (i = 0; i < len; i++)
+      {
+         if (span[i] != (uint8_t)(received + i))
+         {
+            printf ("stress: mismatch at byte %" PRIu32 "\n", received + i);
+            exit (EXIT_FAILURE);
+         }
+      }
+      ring_buffer_consume (&new_rb, len);
+      received += len;
+      if (len == 0)
+      {
+         sched_yield();
+      }
+   }
+
+   pthread_join (producer, NULL);
+   printf ("stress: %" PRIu32 " bytes ok\n", received);
+   return 0;
+}
+
+int main (void)
+{
+   bench_old();
+   bench_new_byte();
+   bench_new_bulk();
+   return stress();
+}